@@ -0,0 +1,76 @@
+/**
+ * example code for spLogHelper library
+ *
+ *
+ */
+
+#include <filesystem>
+#include <thread>
+#include <spLogHelper.h>
+
+
+void myHandlerFunc1(const char *message, const splhLevel level, const char *timeString,
+                    const char *fileName, const uint32_t lineNo, const char *funcName)
+{
+  printf("1: %s\n", message);
+}
+
+void myStructuredFunc(const char *message, const splhLevel level, const char *timeString,
+                      const char *fileName, const uint32_t lineNo, const char *funcName)
+{
+  // raw context fields of the logging thread
+  printf("2: {\"message\":\"%s\"", message);
+  for (const std::pair<std::string, std::string> &field : spLogContext::fields())
+  {
+    printf(",\"%s\":\"%s\"", field.first.c_str(), field.second.c_str());
+  }
+  printf("}\n");
+}
+
+
+void handleRequest(const char *requestId, const char *tenant)
+{
+  spLOG_CONTEXT("req", requestId);
+  spLOG_CONTEXT("tenant", tenant);
+  spLOG_I("request started");
+  spLOGF_I("loaded %d items", 3);
+}
+
+
+/**
+ * @brief our main function
+ *
+ */
+int main(int argc, char *argv[])
+{
+  std::string a = argv[0];
+  printf("running %s\n", a.substr(a.rfind(std::filesystem::path::preferred_separator) + 1).c_str());
+  // ========================================================
+
+  uint32_t id1 = spLOG_REG(myHandlerFunc1);
+  spLOG_FORMAT({splhFormat::LEVEL, splhFormat::THREAD_ID, splhFormat::CONTEXT, splhFormat::FUNCTION});
+
+  spLogContext::setThreadName("main");
+  spLOG_I("no context yet");
+  handleRequest("a17", "acme");
+  spLOG_I("context removed at the end of handleRequest()");
+
+  std::thread worker([]()
+  {
+    spLogContext::push("job", "cleanup");
+    spLOG_I("from a worker thread");
+    spLogContext::pop();
+  });
+  worker.join();
+
+  // a second object passing the fields separately
+  spLogHelper structuredLH;
+  structuredLH.setMessageFormat();
+  uint32_t id2 = structuredLH.registerHandlerCallback(myStructuredFunc);
+  handleRequest("b42", "globex");
+
+
+  // ========================================================
+  printf("done\n");
+  return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * example code for spLogHelper library
+ *
+ *
+ */
+
+#include <filesystem>
+#include <spLogHelper.h>
+#include <spLogStore.h>
+
+
+bool myQueryFunc(const splhStoreRecord &record)
+{
+  printf("found: %lld [%u][%s:%u] %s(): %s\n", (long long)record.time, (uint32_t)record.level,
+         record.fileName, record.lineNo, record.funcName, record.message);
+  return true;
+}
+
+
+void connect(int attempt)
+{
+  if (attempt % 100 == 99)
+  {
+    spLOGF_E("connection attempt %d failed", attempt);
+  }
+  else
+  {
+    spLOGF_D("connecting, attempt %d", attempt);
+  }
+}
+
+
+/**
+ * @brief our main function
+ *
+ */
+int main(int argc, char *argv[])
+{
+  std::string a = argv[0];
+  printf("running %s\n", a.substr(a.rfind(std::filesystem::path::preferred_separator) + 1).c_str());
+  // ========================================================
+
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "splh-store-xmpl";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  // store with plain messages, as the other elements are stored separately
+  spLogStore store(dir.string().c_str(), 1000);
+  spLOG_FORMAT();
+  uint32_t id1 = spLOG_REG(store.handlerCallback());
+
+  for (int i = 0; i < 500; i++)
+  {
+    connect(i);
+  }
+  spLOG_I("all done");
+
+  // all errors from connect()
+  splhStoreQuery query;
+  query.levelMask = 1 << (uint32_t)splhLevel::ERROR;
+  query.funcName = "connect";
+  size_t count = store.query(query, myQueryFunc);
+  printf("%zu errors\n", count);
+
+  // everything from this file at INFO or above during the last minute
+  query = splhStoreQuery();
+  query.levelMask = (uint8_t)(0xFF << (uint32_t)splhLevel::INFO);
+  query.fileName = "xmpl-log-store.cpp";
+  query.fromTime = (int64_t)(time(nullptr) - 60) * 1000000000;
+  count = store.query(query, myQueryFunc);
+  printf("%zu records at INFO or above\n", count);
+
+  spLOG_UNREG(id1);
+
+
+  // ========================================================
+  printf("done\n");
+  return 0;
+}
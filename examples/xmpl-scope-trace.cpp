@@ -0,0 +1,82 @@
+/**
+ * example code for spLogHelper library
+ *
+ *
+ */
+
+#include <filesystem>
+#include <thread>
+#include <spLogHelper.h>
+#include <spLogTrace.h>
+
+
+void myHandlerFunc1(const char *message, const splhLevel level, const char *timeString,
+                    const char *fileName, const uint32_t lineNo, const char *funcName)
+{
+  printf("1: %s\n", message);
+}
+
+
+void parseRequest()
+{
+  spLOG_SCOPE("parse");
+  std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+void handleRequest(int requestNo)
+{
+  spLOG_SCOPE("request");
+  parseRequest();
+  {
+    spLOG_SCOPE("query database");
+    std::this_thread::sleep_for(std::chrono::microseconds(500 + 100 * requestNo));
+  }
+}
+
+
+/**
+ * @brief our main function
+ *
+ */
+int main(int argc, char *argv[])
+{
+  std::string a = argv[0];
+  printf("running %s\n", a.substr(a.rfind(std::filesystem::path::preferred_separator) + 1).c_str());
+  // ========================================================
+
+  uint32_t id1 = spLOG_REG(myHandlerFunc1);
+
+  // spans of two threads
+  std::thread worker([]()
+  {
+    for (int i = 0; i < 5; i++)
+    {
+      handleRequest(i);
+    }
+  });
+  for (int i = 0; i < 3; i++)
+  {
+    handleRequest(i);
+  }
+  worker.join();
+
+  // overhead of an empty scope
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 4000; i++)
+  {
+    spLOG_SCOPE("empty");
+  }
+  double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  spLOGF_I("an empty scope takes %.1f ns", nanos / 4000);
+
+  // open the file with chrome://tracing or https://ui.perfetto.dev
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "splh-trace.json";
+  spLogTrace::writeChromeTrace(path.string().c_str());
+  spLOGF_I("trace written to %s, %llu spans dropped", path.string().c_str(),
+           (unsigned long long)spLogTrace::dropped());
+
+
+  // ========================================================
+  printf("done\n");
+  return 0;
+}
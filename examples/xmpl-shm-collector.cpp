@@ -0,0 +1,202 @@
+/**
+ * example code for spLogHelper library
+ *
+ * Started without arguments, it runs a stress test with several forked workers logging into a shared memory ring
+ * and the parent process collecting the records. The workers wait for the collector when their slots are full,
+ * so no records get dropped. One worker crashes on purpose after logging, but its records are still collected.
+ *
+ * Started with "collect <name>", it runs as a standalone collector printing the records of the ring named <name>
+ * until interrupted.
+ *
+ */
+
+#include <filesystem>
+#include <signal.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <spLogHelper.h>
+#include <spLogShmRing.h>
+
+
+#define WORKER_COUNT      8
+#define WORKER_THREADS    4
+#define WORKER_RECORDS    20000
+#define CRASHING_WORKER   (WORKER_COUNT - 1)
+
+volatile sig_atomic_t stopCollector = 0;
+uint64_t collected = 0;
+uint64_t workerRecords[WORKER_COUNT];
+uint64_t lastRecordNo[WORKER_COUNT][WORKER_THREADS];
+uint64_t outOfOrder = 0;
+bool crashRecordCollected = false;
+
+
+void myHandlerFunc1(const char *message, const splhLevel level, const char *timeString,
+                    const char *fileName, const uint32_t lineNo, const char *funcName)
+{
+  printf("1: %s\n", message);
+}
+
+void myCountingFunc(const char *message, const splhLevel level, const char *timeString,
+                    const char *fileName, const uint32_t lineNo, const char *funcName)
+{
+  // message is "w<worker>/<thread> record <no>"
+  unsigned int worker, thread;
+  unsigned long long recordNo;
+  if (sscanf(message, "w%u/%u record %llu", &worker, &thread, &recordNo) == 3
+      && worker < WORKER_COUNT && thread < WORKER_THREADS)
+  {
+    if (recordNo != 0 && recordNo <= lastRecordNo[worker][thread])
+    {
+      outOfOrder++;
+    }
+    lastRecordNo[worker][thread] = recordNo;
+    workerRecords[worker]++;
+  }
+  else if (sscanf(message, "w%u crashing now", &worker) == 1 && worker == CRASHING_WORKER)
+  {
+    crashRecordCollected = true;
+  }
+  collected++;
+}
+
+
+/**
+ * @brief a worker process logging via the shared memory ring
+ *
+ */
+void worker(const char *name, uint32_t workerNo)
+{
+  spLogShmRing ring;
+  if (!ring.open(name))
+  {
+    _exit(1);
+  }
+  spLOG_FORMAT();
+  // back-pressure, wait up to a second for the collector when the slots are full
+  spLOG_REG(ring.producerCallback(1000000));
+
+  std::thread threads[WORKER_THREADS];
+  for (uint32_t t = 0; t < WORKER_THREADS; t++)
+  {
+    threads[t] = std::thread([workerNo, t]()
+    {
+      for (uint64_t i = 1; i <= WORKER_RECORDS; i++)
+      {
+        spLOGF_I("w%u/%u record %llu", workerNo, t, (unsigned long long)i);
+      }
+    });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  // the last worker crashes, but the records written before stay in the ring
+  if (workerNo == CRASHING_WORKER)
+  {
+    spLOGF_C("w%u crashing now", workerNo);
+    abort();
+  }
+  _exit(0);
+}
+
+
+/**
+ * @brief runs as collector for an existing ring
+ *
+ */
+int collect(const char *name)
+{
+  spLogShmRing ring;
+  if (!ring.open(name))
+  {
+    printf("cannot open %s\n", name);
+    return 1;
+  }
+  spLOG_REG(myHandlerFunc1);
+  signal(SIGINT, [](int) { stopCollector = 1; });
+  while (!stopCollector)
+  {
+    if (ring.drain(spDefaultLogHelper) == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  return 0;
+}
+
+
+/**
+ * @brief our main function
+ *
+ */
+int main(int argc, char *argv[])
+{
+  std::string a = argv[0];
+  printf("running %s\n", a.substr(a.rfind(std::filesystem::path::preferred_separator) + 1).c_str());
+  // ========================================================
+
+  if (argc == 3 && std::string(argv[1]) == "collect")
+  {
+    return collect(argv[2]);
+  }
+
+  const char *name = "/splh-xmpl-ring";
+  spLogShmRing ring;
+  if (!ring.create(name))
+  {
+    printf("cannot create %s\n", name);
+    return 1;
+  }
+
+  pid_t pids[WORKER_COUNT];
+  for (uint32_t w = 0; w < WORKER_COUNT; w++)
+  {
+    pids[w] = fork();
+    if (pids[w] == 0)
+    {
+      worker(name, w);
+    }
+  }
+
+  // collector with the actual sink registered in this process only
+  spLOG_FORMAT();
+  spLOG_REG(myCountingFunc);
+  uint32_t running = WORKER_COUNT;
+  auto start = std::chrono::steady_clock::now();
+  while (running > 0)
+  {
+    if (ring.drain(spDefaultLogHelper) == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    int status;
+    while (waitpid(-1, &status, WNOHANG) > 0)
+    {
+      running--;
+    }
+  }
+  while (ring.drain(spDefaultLogHelper) > 0)
+  {
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  ring.unlink();
+
+  uint64_t expected = (uint64_t)WORKER_COUNT * WORKER_THREADS * WORKER_RECORDS + 1;
+  printf("collected %llu of %llu records in %.3f s, %llu dropped, %llu out of order\n",
+         (unsigned long long)collected, (unsigned long long)expected, seconds,
+         (unsigned long long)ring.dropped(), (unsigned long long)outOfOrder);
+
+  // everything the crashed worker wrote before abort() must have been collected
+  bool crashedComplete = crashRecordCollected && workerRecords[CRASHING_WORKER] == WORKER_THREADS * WORKER_RECORDS;
+  printf("crashed worker: %llu of %u records and %s crash record collected\n",
+         (unsigned long long)workerRecords[CRASHING_WORKER], WORKER_THREADS * WORKER_RECORDS,
+         crashRecordCollected ? "its" : "NOT its");
+
+
+  // ========================================================
+  printf("done\n");
+  return (crashedComplete && collected == expected && ring.dropped() == 0 && outOfOrder == 0) ? 0 : 1;
+}
@@ -18,6 +18,11 @@ void myHandlerFunc2(const char *message, const splhLevel level, const char *time
 {
   printf("2: %s\n", message);
 }
+void myHandlerFunc3(const char *message, const splhLevel level, const char *timeString, const int64_t timestamp,
+                    const char *fileName, const uint32_t lineNo, const char *funcName)
+{
+  printf("3: %lld.%09lld %s\n", (long long)(timestamp / 1000000000), (long long)(timestamp % 1000000000), message);
+}
 
 
 /**
@@ -47,6 +52,13 @@ int main(int argc, char *argv[])
   std::string f = spDefaultLogHelper.getTimeFormat();
   spLOGF_I("the current time format string is '%s'", f.c_str());
 
+  // callback receiving the timestamp in nanoseconds since epoch
+  spLOG_UNREG(id1);
+  uint32_t id3 = spLOG_REG(myHandlerFunc3);
+  spLOG_FORMAT();
+  spLOG_I("first message with timestamp");
+  spLOG_I("second message with timestamp");
+
 
   // ========================================================
   printf("done\n");
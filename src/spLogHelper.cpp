@@ -9,7 +9,28 @@
  */
 
 #include <spLogHelper.h>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <ctype.h>
+#include <string.h>
 #include <vector>
+#ifndef SPLH_NO_THREADS
+#include <mutex>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+
+// buffers and context are per thread when threads are supported
+#ifndef SPLH_NO_THREADS
+#define SPLH_THREAD_LOCAL thread_local
+#else
+#define SPLH_THREAD_LOCAL
+#endif
 
 // default object
 spLogHelper spDefaultLogHelper;
@@ -18,15 +39,754 @@ spLogHelper spDefaultLogHelper;
 uint32_t cbNextID = 0;
 std::vector<uint32_t> regIDs;
 std::vector<spLogHelper*> regOwners;
-std::vector<splhHandlerCallback> regCallbacks;
+std::vector<splhTimestampHandlerCallback> regCallbacks;
 
 
 // for level to text conversion
 std::array<const char*, 7> splhLevelText = {"ALL", "DEBUG", "INFO", "WARNING", "ERROR", "CRITICAL", "NONE"};
 
 
-// message buffer
-char* pMsgBuffer = nullptr;
+// message buffer, one per thread to allow logging from several threads
+SPLH_THREAD_LOCAL char msgBuffer[spLOGHELPER_MSGBUFFER_LEN];
+
+
+// clock calibration, renewed under clockMutex and read without lock, as a sequence counter tells whether it was
+// changed while reading (seqlock)
+struct splhClockCalibration
+{
+  std::atomic<uint64_t> sequence{0};          // odd while being renewed, 0 before the first calibration
+  std::atomic<uint64_t> baseTicks{0};         // ticks and system clock at the last calibration
+  std::atomic<int64_t> baseNanos{0};
+  std::atomic<double> nanosPerTick{1.0};
+  std::atomic<uint64_t> recalibrationTicks{0};
+};
+splhClockCalibration clockCalibration;
+
+// ticks and steady clock at the first calibration, only used under clockMutex
+struct splhClockReference
+{
+  bool valid = false;
+  uint64_t ticks = 0;
+  int64_t steadyNanos = 0;
+};
+splhClockReference clockReference;
+#ifndef SPLH_NO_THREADS
+std::mutex clockMutex;
+#endif
+
+
+// context fields and rendered prefixes of each thread
+struct splhContextData
+{
+  std::vector<std::pair<std::string, std::string>> fields;
+  std::string prefix;
+  std::string threadId;
+};
+SPLH_THREAD_LOCAL splhContextData contextData;
+// number of each thread, shared with the spans of spLogTrace
+SPLH_THREAD_LOCAL uint32_t contextThreadNo = 0;
+std::atomic<uint32_t> contextNextThreadNo{1};
+
+
+/**
+ * @brief Returns the steady clock in nanoseconds.
+ */
+static int64_t steadyNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Returns the system clock in nanoseconds since epoch.
+ */
+static int64_t systemNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Renews the calibration of splhClock ticks against the system clock and publishes it to toNanos().
+ * 
+ * @param tsc     true when ticks are TSC values, which need their rate to be measured
+ * @param wait    false to skip the renewal, when another thread is already renewing it
+ * @return true   when the calibration was renewed
+ * @return false
+ */
+static bool calibrateClock(bool tsc, bool wait)
+{
+#ifndef SPLH_NO_THREADS
+  std::unique_lock<std::mutex> lock(clockMutex, std::defer_lock);
+  if (wait)
+  {
+    lock.lock();
+  }
+  else if (!lock.try_lock())
+  {
+    return false;
+  }
+#endif
+  splhClockCalibration &cal = clockCalibration;
+  splhClockReference &ref = clockReference;
+
+  // tick rate, measured over the time since the first calibration, which gets more precise with time
+  int64_t interval = 1000000000;
+  double nanosPerTick = 1.0;
+  if (tsc)
+  {
+    uint64_t ticks = splhClock::ticks();
+    int64_t steady = steadyNanos();
+    if (!ref.valid)
+    {
+      ref.ticks = ticks;
+      ref.steadyNanos = steady;
+      ref.valid = true;
+      while (steady - ref.steadyNanos < 1000000)
+      {
+        ticks = splhClock::ticks();
+        steady = steadyNanos();
+      }
+    }
+    nanosPerTick = (double)(steady - ref.steadyNanos) / (double)(ticks - ref.ticks);
+    if (interval > 10 * (steady - ref.steadyNanos))
+    {
+      interval = 10 * (steady - ref.steadyNanos);
+    }
+  }
+
+  // system clock read between two ticks
+  uint64_t before = splhClock::ticks();
+  int64_t nanos = systemNanos();
+  uint64_t after = splhClock::ticks();
+  uint64_t baseTicks = before + (after - before) / 2;
+
+  // publish, readers retry while the sequence is odd or has changed
+  uint64_t sequence = cal.sequence.load(std::memory_order_relaxed);
+  cal.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  cal.baseTicks.store(baseTicks, std::memory_order_relaxed);
+  cal.baseNanos.store(nanos, std::memory_order_relaxed);
+  cal.nanosPerTick.store(nanosPerTick, std::memory_order_relaxed);
+  cal.recalibrationTicks.store(baseTicks + (uint64_t)(interval / nanosPerTick), std::memory_order_relaxed);
+  cal.sequence.store(sequence + 2, std::memory_order_release);
+  return true;
+}
+
+
+/**
+ * @brief Returns whether the CPU has an invariant TSC to be used for ticks().
+ * 
+ * @return true 
+ * @return false 
+ */
+bool splhClock::useTsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool invariantTsc = []()
+  {
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8));
+  }();
+  return invariantTsc;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Returns the current value of the clock in ticks, to be converted with toNanos().
+ * 
+ * @return uint64_t   TSC value or nanoseconds of the steady clock
+ */
+uint64_t splhClock::ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (useTsc())
+  {
+    return __rdtsc();
+  }
+#endif
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Converts ticks into nanoseconds since epoch. Renews the calibration, when it is older than a second
+ *        (or shortly after the start, while the TSC rate is still being measured). The calibration is read without
+ *        locking, only the thread renewing it takes a lock.
+ * 
+ * @param ticks       a value returned by ticks()
+ * @return int64_t    nanoseconds since epoch
+ */
+int64_t splhClock::toNanos(uint64_t ticks)
+{
+  splhClockCalibration &cal = clockCalibration;
+  bool renewed = false;
+  while (true)
+  {
+    uint64_t sequence = cal.sequence.load(std::memory_order_acquire);
+    if (sequence == 0)
+    {
+      calibrateClock(useTsc(), true);
+      continue;
+    }
+    if (sequence & 1)
+    {
+      continue;
+    }
+    uint64_t baseTicks = cal.baseTicks.load(std::memory_order_relaxed);
+    int64_t baseNanos = cal.baseNanos.load(std::memory_order_relaxed);
+    double nanosPerTick = cal.nanosPerTick.load(std::memory_order_relaxed);
+    uint64_t recalibrationTicks = cal.recalibrationTicks.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (cal.sequence.load(std::memory_order_relaxed) != sequence)
+    {
+      continue;
+    }
+
+    // renewed by one thread, the others go on with the current calibration
+    if (!renewed && (int64_t)(ticks - recalibrationTicks) > 0 && calibrateClock(useTsc(), false))
+    {
+      renewed = true;
+      continue;
+    }
+    return baseNanos + (int64_t)((double)(int64_t)(ticks - baseTicks) * nanosPerTick);
+  }
+}
+
+/**
+ * @brief Renews the calibration of ticks against the system clock. Done automatically by toNanos(), but may also
+ *        be called by the application, e.g. from a timer or after the system clock was set.
+ * 
+ */
+void splhClock::calibrate()
+{
+  calibrateClock(useTsc(), true);
+}
+
+
+/**
+ * @brief Renders the context fields of the calling thread into its prefix.
+ * 
+ */
+static void renderContextPrefix()
+{
+  std::string &prefix = contextData.prefix;
+  prefix.clear();
+  for (std::pair<std::string, std::string> &field : contextData.fields)
+  {
+    prefix.append(prefix.empty() ? "[" : " ").append(field.first).append("=").append(field.second);
+  }
+  if (!prefix.empty())
+  {
+    prefix.append("]");
+  }
+}
+
+/**
+ * @brief Adds a field to the context of the calling thread. A nullptr key or value is shown as "(null)", like for
+ *        %s in logf().
+ * 
+ * @param key     name of the field, e.g. "req"
+ * @param value   value of the field
+ */
+void spLogContext::push(const char *key, const char *value)
+{
+  contextData.fields.emplace_back((key != nullptr) ? key : "(null)", (value != nullptr) ? value : "(null)");
+  renderContextPrefix();
+}
+
+/**
+ * @brief Removes the field added last from the context of the calling thread.
+ * 
+ */
+void spLogContext::pop()
+{
+  if (!contextData.fields.empty())
+  {
+    contextData.fields.pop_back();
+    renderContextPrefix();
+  }
+}
+
+/**
+ * @brief Removes all fields from the context of the calling thread.
+ * 
+ */
+void spLogContext::clear()
+{
+  contextData.fields.clear();
+  contextData.prefix.clear();
+}
+
+/**
+ * @brief Returns the context fields of the calling thread, e.g. for a callback passing them on separately.
+ * 
+ * @return const std::vector<std::pair<std::string, std::string>>&    the key / value pairs in the order added
+ */
+const std::vector<std::pair<std::string, std::string>>& spLogContext::fields()
+{
+  return contextData.fields;
+}
+
+/**
+ * @brief Returns the rendered context of the calling thread as used for splhFormat::CONTEXT.
+ * 
+ * @return const std::string&   "[key=value key=value]" or empty without fields
+ */
+const std::string& spLogContext::prefix()
+{
+  return contextData.prefix;
+}
+
+/**
+ * @brief Sets the name of the calling thread to be used for splhFormat::THREAD_ID instead of its number. A nullptr
+ *        name is shown as "(null)".
+ * 
+ * @param name  the thread's name
+ */
+void spLogContext::setThreadName(const char *name)
+{
+  contextData.threadId = std::string("[") + ((name != nullptr) ? name : "(null)") + "]";
+}
+
+/**
+ * @brief Returns the rendered id of the calling thread as used for splhFormat::THREAD_ID.
+ * 
+ * @return const std::string&   "[name]" or "[number]", with threads numbered in the order of their first use
+ */
+const std::string& spLogContext::threadId()
+{
+  if (contextData.threadId.empty())
+  {
+    contextData.threadId = "[" + std::to_string(threadNo()) + "]";
+  }
+  return contextData.threadId;
+}
+
+/**
+ * @brief Returns the number of the calling thread, as shown by splhFormat::THREAD_ID unless a name was set and used
+ *        as tid of the thread's spans in spLogTrace.
+ * 
+ * @return uint32_t   the number, with threads numbered in the order of their first use
+ */
+uint32_t spLogContext::threadNo()
+{
+  if (contextThreadNo == 0)
+  {
+    contextThreadNo = contextNextThreadNo.fetch_add(1, std::memory_order_relaxed);
+  }
+  return contextThreadNo;
+}
+
+
+/**
+ * @brief output position of the built-in formatter, which counts all chars but only writes those fitting into
+ *        the buffer
+ */
+struct splhFormatOutput
+{
+  char *buffer;
+  size_t limit;
+  size_t used;
+
+  void append(const char *text, size_t len)
+  {
+    if (used < limit)
+    {
+      memcpy(buffer + used, text, (len < limit - used) ? len : limit - used);
+    }
+    used += len;
+  }
+
+  void appendText(const char *text)
+  {
+    append(text, strlen(text));
+  }
+
+  void appendNumber(uint32_t value)
+  {
+    char digits[12];
+    append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+  }
+
+  void pad(char c, int count)
+  {
+    if (count > 0)
+    {
+      if (used < limit)
+      {
+        memset(buffer + used, c, ((size_t)count < limit - used) ? count : limit - used);
+      }
+      used += count;
+    }
+  }
+
+  void terminate()
+  {
+    buffer[(used < limit) ? used : limit] = 0;
+  }
+};
+
+
+/**
+ * @brief Writes a formatted number with sign / prefix, zero padding and width like printf().
+ *
+ * @param out         formatter output
+ * @param prefix      sign or other prefix, may be empty
+ * @param prefixLen   length of prefix
+ * @param digits      the number's chars
+ * @param digitsLen   length of digits
+ * @param zeros       leading zeros to insert between prefix and digits
+ * @param width       minimum field width
+ * @param leftAlign   true for '-' flag
+ */
+static void appendField(splhFormatOutput &out, const char *prefix, size_t prefixLen, const char *digits,
+                        size_t digitsLen, int zeros, int width, bool leftAlign)
+{
+  int padding = width - (int)(prefixLen + digitsLen) - (zeros > 0 ? zeros : 0);
+  if (!leftAlign)
+  {
+    out.pad(' ', padding);
+  }
+  out.append(prefix, prefixLen);
+  out.pad('0', zeros);
+  out.append(digits, digitsLen);
+  if (leftAlign)
+  {
+    out.pad(' ', padding);
+  }
+}
+
+
+/**
+ * @brief Formats the message into buffer for the common printf() specifiers, i.e. %d %i %u %x %X %o %c %s %p
+ *        %f %F %e %E %g %G and %% with flags '-', '+', ' ', '0', width, precision and length modifiers.
+ *        Anything else (e.g. '*' for width or precision, '#' flag, flags or precision for %p, %n, %a, long double)
+ *        or arguments not matching their specifiers make it return -1 and leave the formatting to snprintf().
+ *
+ * @param buffer      buffer to write to
+ * @param bufferLen   size of buffer
+ * @param format      a format string with printf() specifiers
+ * @param args        the arguments
+ * @param argCount    number of arguments
+ * @return int        length of the complete message like snprintf() or -1 if not supported
+ */
+int splhFormatMessage(char *buffer, size_t bufferLen, const char *format, const splhArg *args, size_t argCount)
+{
+  if (bufferLen == 0)
+  {
+    return -1;
+  }
+
+  splhFormatOutput out = {buffer, bufferLen - 1, 0};
+  size_t argIndex = 0;
+  const char *p = format;
+
+  while (*p)
+  {
+    // literal text
+    const char *pPercent = strchr(p, '%');
+    if (pPercent == nullptr)
+    {
+      out.append(p, strlen(p));
+      break;
+    }
+    out.append(p, pPercent - p);
+    p = pPercent + 1;
+
+    // flags
+    bool leftAlign = false;
+    bool zeroPad = false;
+    char signChar = 0;
+    while (true)
+    {
+      if (*p == '-')
+      {
+        leftAlign = true;
+      }
+      else if (*p == '0')
+      {
+        zeroPad = true;
+      }
+      else if (*p == '+')
+      {
+        signChar = '+';
+      }
+      else if (*p == ' ')
+      {
+        if (signChar == 0)
+        {
+          signChar = ' ';
+        }
+      }
+      else
+      {
+        break;
+      }
+      p++;
+    }
+
+    // width & precision
+    int width = 0;
+    while (*p >= '0' && *p <= '9')
+    {
+      width = width * 10 + (*p++ - '0');
+      if (width > 4096)
+      {
+        return -1;
+      }
+    }
+    int precision = -1;
+    if (*p == '.')
+    {
+      p++;
+      precision = 0;
+      while (*p >= '0' && *p <= '9')
+      {
+        precision = precision * 10 + (*p++ - '0');
+        if (precision > 4096)
+        {
+          return -1;
+        }
+      }
+    }
+
+    // length modifier
+    char length = 0;
+    if (*p == 'h' || *p == 'l')
+    {
+      length = *p++;
+      if (*p == length)
+      {
+        length = (length == 'h') ? 'H' : 'L';
+        p++;
+      }
+    }
+    else if (*p == 'z' || *p == 'j' || *p == 't')
+    {
+      length = *p++;
+    }
+
+    char conversion = *p++;
+    if (conversion == '%')
+    {
+      out.append("%", 1);
+      continue;
+    }
+    if (conversion == 0 || argIndex >= argCount)
+    {
+      return -1;
+    }
+    const splhArg &arg = args[argIndex++];
+
+    switch (conversion)
+    {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c':
+      {
+        if (arg.type != splhArgType::INT && arg.type != splhArgType::UINT)
+        {
+          return -1;
+        }
+
+        // value as the specifier's type would see it
+        uint64_t raw = arg.u;
+        bool isSigned = (conversion == 'd' || conversion == 'i');
+        int64_t sValue;
+        uint64_t uValue;
+        switch (length)
+        {
+        case 'H':
+          sValue = (signed char)raw;
+          uValue = (unsigned char)raw;
+          break;
+        case 'h':
+          sValue = (short)raw;
+          uValue = (unsigned short)raw;
+          break;
+        case 'l':
+          sValue = (long)raw;
+          uValue = (unsigned long)raw;
+          break;
+        case 'L':
+          sValue = (long long)raw;
+          uValue = (unsigned long long)raw;
+          break;
+        case 'z':
+          sValue = (std::make_signed<size_t>::type)raw;
+          uValue = (size_t)raw;
+          break;
+        case 'j':
+          sValue = (intmax_t)raw;
+          uValue = (uintmax_t)raw;
+          break;
+        case 't':
+          sValue = (ptrdiff_t)raw;
+          uValue = (std::make_unsigned<ptrdiff_t>::type)raw;
+          break;
+        default:
+          sValue = (int)raw;
+          uValue = (unsigned int)raw;
+          break;
+        }
+
+        if (conversion == 'c')
+        {
+          char c = (char)raw;
+          appendField(out, "", 0, &c, 1, 0, width, leftAlign);
+          break;
+        }
+
+        char prefix[1];
+        size_t prefixLen = 0;
+        if (isSigned)
+        {
+          if (sValue < 0)
+          {
+            prefix[prefixLen++] = '-';
+            uValue = 0 - (uint64_t)sValue;
+          }
+          else
+          {
+            uValue = sValue;
+            if (signChar != 0)
+            {
+              prefix[prefixLen++] = signChar;
+            }
+          }
+        }
+
+        char digits[24];
+        size_t digitsLen = 0;
+        if (uValue != 0 || precision != 0)
+        {
+          int base = (conversion == 'x' || conversion == 'X') ? 16 : (conversion == 'o') ? 8 : 10;
+          digitsLen = std::to_chars(digits, digits + sizeof(digits), uValue, base).ptr - digits;
+          if (conversion == 'X')
+          {
+            for (size_t i = 0; i < digitsLen; i++)
+            {
+              digits[i] = toupper(digits[i]);
+            }
+          }
+        }
+
+        int zeros = 0;
+        if (precision >= 0)
+        {
+          zeros = precision - (int)digitsLen;
+        }
+        else if (zeroPad && !leftAlign)
+        {
+          zeros = width - (int)(prefixLen + digitsLen);
+        }
+        appendField(out, prefix, prefixLen, digits, digitsLen, zeros, width, leftAlign);
+      }
+      break;
+
+    case 's':
+      {
+        if (arg.type != splhArgType::STRING || length != 0)
+        {
+          return -1;
+        }
+        const char *text = (arg.s != nullptr) ? arg.s : "(null)";
+        size_t textLen = (precision >= 0) ? strnlen(text, precision) : strlen(text);
+        appendField(out, "", 0, text, textLen, 0, width, leftAlign);
+      }
+      break;
+
+#ifdef __GLIBC__
+    case 'p':
+      {
+        // flags and precision are treated differently by printf() implementations for %p
+        if ((arg.type != splhArgType::POINTER && arg.type != splhArgType::STRING) || length != 0
+            || leftAlign || zeroPad || signChar != 0 || precision >= 0)
+        {
+          return -1;
+        }
+        if (arg.p == nullptr)
+        {
+          appendField(out, "", 0, "(nil)", 5, 0, width, leftAlign);
+          break;
+        }
+        char digits[24];
+        size_t digitsLen = std::to_chars(digits, digits + sizeof(digits), (uintptr_t)arg.p, 16).ptr - digits;
+        appendField(out, "0x", 2, digits, digitsLen, 0, width, leftAlign);
+      }
+      break;
+#endif
+
+#ifdef __cpp_lib_to_chars
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+      {
+        if (arg.type != splhArgType::DOUBLE || (length != 0 && length != 'l') || precision > 100)
+        {
+          return -1;
+        }
+        std::chars_format fmt = (conversion == 'f' || conversion == 'F') ? std::chars_format::fixed
+                              : (conversion == 'e' || conversion == 'E') ? std::chars_format::scientific
+                              : std::chars_format::general;
+        char digits[400];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), arg.d, fmt,
+                                                    (precision >= 0) ? precision : 6);
+        if (result.ec != std::errc())
+        {
+          return -1;
+        }
+        size_t digitsLen = result.ptr - digits;
+        if (conversion == 'F' || conversion == 'E' || conversion == 'G')
+        {
+          for (size_t i = 0; i < digitsLen; i++)
+          {
+            digits[i] = toupper(digits[i]);
+          }
+        }
+
+        char prefix[1];
+        size_t prefixLen = 0;
+        const char *pDigits = digits;
+        if (*pDigits == '-')
+        {
+          prefix[prefixLen++] = '-';
+          pDigits++;
+          digitsLen--;
+        }
+        else if (signChar != 0)
+        {
+          prefix[prefixLen++] = signChar;
+        }
+
+        int zeros = 0;
+        if (zeroPad && !leftAlign && std::isfinite(arg.d))
+        {
+          zeros = width - (int)(prefixLen + digitsLen);
+        }
+        appendField(out, prefix, prefixLen, pDigits, digitsLen, zeros, width, leftAlign);
+      }
+      break;
+#endif
+
+    default:
+      return -1;
+    }
+  }
+
+  out.terminate();
+  return (int)out.used;
+}
 
 
 /*    PUBLIC    PUBLIC    PUBLIC    PUBLIC    
@@ -75,6 +835,23 @@ spLogHelper::~spLogHelper()
  * @return uint32_t   an unique ID for this registration
  */
 uint32_t spLogHelper::registerHandlerCallback(const splhHandlerCallback callback)
+{
+  return registerHandlerCallback([callback](const char *message, const splhLevel level, const char *timeString,
+                                            const int64_t timestamp, const char *fileName, const uint32_t lineNo,
+                                            const char *funcName)
+  {
+    callback(message, level, timeString, fileName, lineNo, funcName);
+  });
+}
+
+/**
+ * @brief Registers a callback function, which will be invoked each time logf() or a log macro is used and
+ *        additionally receives the timestamp of the message in nanoseconds since epoch.
+ * 
+ * @param callback    the handler function to be called
+ * @return uint32_t   an unique ID for this registration
+ */
+uint32_t spLogHelper::registerHandlerCallback(const splhTimestampHandlerCallback callback)
 {
   regIDs.emplace_back(cbNextID);
   regOwners.insert(regOwners.end(), this);
@@ -132,6 +909,29 @@ void spLogHelper::setMessageFormat(std::initializer_list<splhFormat> formatList)
   _formatList = formatList;
  }
 
+/**
+ * @brief Passes a message, which was created elsewhere (e.g. in another process), on to each registered callback
+ *        like logf() does with its formatted message.
+ * 
+ * @param level     a splhLevel value
+ * @param fileName  the name of the file
+ * @param lineNo    the number of the line
+ * @param funcName  the name of the function
+ * @param timestamp nanoseconds since epoch
+ * @param message   the message text
+ */
+void spLogHelper::dispatch(const splhLevel level, const char *fileName, const uint32_t lineNo, const char *funcName,
+                           const int64_t timestamp, const char *message)
+{
+  if (callbacksExist())
+  {
+    char *pBuffer = getMsgBufferPointer();
+    strncpy(pBuffer, message, spLOGHELPER_MSGBUFFER_LEN - 1);
+    pBuffer[spLOGHELPER_MSGBUFFER_LEN - 1] = 0;
+    handleCallbacks(level, extractFileName(fileName), lineNo, funcName, timestamp);
+  }
+}
+
 
 /*    PRIVATE    PRIVATE    PRIVATE    PRIVATE
 
@@ -147,17 +947,13 @@ void spLogHelper::setMessageFormat(std::initializer_list<splhFormat> formatList)
       PRIVATE    PRIVATE    PRIVATE    PRIVATE    */
 
 /**
- * @brief Ensudres that a message buffer exists and returns a pointer to it.
+ * @brief Returns a pointer to the message buffer of the calling thread.
  * 
  * @return char*    pointer to char buffer
  */
 char* spLogHelper::getMsgBufferPointer()
 {
-  if (pMsgBuffer == nullptr)
-  {
-    pMsgBuffer = (char*)malloc(spLOGHELPER_MSGBUFFER_LEN);
-  }
-  return pMsgBuffer;
+  return msgBuffer;
 }
 
 /**
@@ -224,16 +1020,18 @@ bool spLogHelper::callbacksExist()
  * @param fileName 
  * @param lineNo 
  * @param funcName 
+ * @param timestamp nanoseconds since epoch
  */
-void spLogHelper::handleCallbacks(const splhLevel level, const char *fileName, const uint32_t lineNo, const char *funcName)
+void spLogHelper::handleCallbacks(const splhLevel level, const char *fileName, const uint32_t lineNo, const char *funcName,
+                                  const int64_t timestamp)
 {
   // buffer to create log message in
   char logBuffer[spLOGHELPER_MSGBUFFER_LEN];
 
-  // time
+  // time, converted when first needed
   char timeBuffer[50];
-  time_t ts = time(nullptr);
-  struct tm tm = *localtime(&ts);
+  struct tm tm;
+  bool tmValid = false;
 
   // loop callbacks
   size_t count = regCallbacks.size();
@@ -242,7 +1040,7 @@ void spLogHelper::handleCallbacks(const splhLevel level, const char *fileName, c
     // spLogHelper object for this callback
     spLogHelper* pLH = regOwners[index];
 
-    int used = 0;
+    splhFormatOutput out = {logBuffer, spLOGHELPER_MSGBUFFER_LEN - 1, 0};
     timeBuffer[0] = 0;
 
     for (splhFormat item : pLH->_formatList)
@@ -252,29 +1050,65 @@ void spLogHelper::handleCallbacks(const splhLevel level, const char *fileName, c
       case splhFormat::TIME:
         if (pLH->_fTimeFormat.length() > 0)
         {
+          if (!tmValid)
+          {
+            time_t ts = (time_t)(timestamp / 1000000000);
+            // reentrant variants, as localtime() returns a shared static buffer
+#ifdef _WIN32
+            localtime_s(&tm, &ts);
+#else
+            localtime_r(&ts, &tm);
+#endif
+            tmValid = true;
+          }
           strftime(timeBuffer, 50, pLH->_fTimeFormat.c_str(), &tm);
-          used += snprintf(logBuffer + used, spLOGHELPER_MSGBUFFER_LEN - used, "[%s]", timeBuffer);
+          out.append("[", 1);
+          out.appendText(timeBuffer);
+          out.append("]", 1);
         }
         break;
       
       case splhFormat::LEVEL:
-        used += snprintf(logBuffer + used, spLOGHELPER_MSGBUFFER_LEN - used, "[%s]", levelText(level));
+        out.append("[", 1);
+        out.appendText(levelText(level));
+        out.append("]", 1);
         break;
       
       case splhFormat::FILENAME_LINE:
-        used += snprintf(logBuffer + used, spLOGHELPER_MSGBUFFER_LEN - used, "[%s:%u]", fileName, lineNo);
+        out.append("[", 1);
+        out.appendText(fileName);
+        out.append(":", 1);
+        out.appendNumber(lineNo);
+        out.append("]", 1);
         break;
       
       case splhFormat::FILENAME:
-        used += snprintf(logBuffer + used, spLOGHELPER_MSGBUFFER_LEN - used, "[%s]", fileName);
+        out.append("[", 1);
+        out.appendText(fileName);
+        out.append("]", 1);
         break;
       
       case splhFormat::LINE:
-        used += snprintf(logBuffer + used, spLOGHELPER_MSGBUFFER_LEN - used, "[%u]", lineNo);
+        out.append("[", 1);
+        out.appendNumber(lineNo);
+        out.append("]", 1);
         break;
       
       case splhFormat::FUNCTION:
-        used += snprintf(logBuffer + used, spLOGHELPER_MSGBUFFER_LEN - used, " %s()", funcName);
+        out.append(" ", 1);
+        out.appendText(funcName);
+        out.append("()", 2);
+        break;
+      
+      case splhFormat::CONTEXT:
+        out.append(contextData.prefix.data(), contextData.prefix.length());
+        break;
+      
+      case splhFormat::THREAD_ID:
+        {
+          const std::string &threadId = spLogContext::threadId();
+          out.append(threadId.data(), threadId.length());
+        }
         break;
       
       default:
@@ -282,21 +1116,20 @@ void spLogHelper::handleCallbacks(const splhLevel level, const char *fileName, c
       }
 
       // max length reached?
-      if (used >= spLOGHELPER_MSGBUFFER_LEN)
+      if (out.used >= out.limit)
       {
         break;
       }
     }
 
-    std::string msgFormat;
-    if (used > 0)
+    if (out.used > 0)
     {
-      msgFormat.append(": ");
+      out.append(": ", 2);
     }
-    msgFormat.append("%s");
-    used += snprintf(logBuffer + used, spLOGHELPER_MSGBUFFER_LEN - used, msgFormat.c_str(), getMsgBufferPointer());
+    out.appendText(getMsgBufferPointer());
+    out.terminate();
 
-    regCallbacks[index](logBuffer, level, timeBuffer, fileName, lineNo, funcName);
+    regCallbacks[index](logBuffer, level, timeBuffer, timestamp, fileName, lineNo, funcName);
 
   }
 
@@ -20,11 +20,23 @@
 #define SPLOGHELPER_H
 
 #include <stdint.h>
+#include <chrono>
 #include <ctime>
 #include <iomanip>
 #include <list>
 #include <string>
+#include <utility>
+#include <vector>
 #include <functional>
+#include <type_traits>
+
+
+// without thread support (e.g. libstdc++ built for a single threaded target, or when defined by the application), the
+// core logging works without locks and thread local buffers, while spLogStore, spLogShmRing and spLogTrace are not
+// available
+#if !defined(SPLH_NO_THREADS) && defined(__GLIBCXX__) && !defined(_GLIBCXX_HAS_GTHREADS)
+#define SPLH_NO_THREADS
+#endif
 
 
 // log levels
@@ -110,6 +122,12 @@ enum class splhLevel
 #define spLOG_UNREG(id)   spDefaultLogHelper.unregisterHandlerCallback(id)
 
 
+// context macro
+#define SPLH_CONCAT_(a, b)   a##b
+#define SPLH_CONCAT(a, b)    SPLH_CONCAT_(a, b)
+#define spLOG_CONTEXT(key, value)   spLogContextScope SPLH_CONCAT(splhContext, __LINE__)(key, value)
+
+
 // size of format buffer used
 #ifndef spLOGHELPER_MSGBUFFER_LEN
 #define spLOGHELPER_MSGBUFFER_LEN  240
@@ -125,15 +143,154 @@ enum class splhFormat : uint16_t
   FILENAME,
   LINE,
   FUNCTION,
+  CONTEXT,
+  THREAD_ID,
+};
+
+
+// argument types for the built-in message formatter
+enum class splhArgType : uint8_t
+{
+  INT,
+  UINT,
+  DOUBLE,
+  STRING,
+  POINTER,
+  OTHER,
+};
+
+
+/**
+ * @brief a logf() argument as passed to the built-in message formatter.
+ *
+ */
+struct splhArg
+{
+  splhArgType type = splhArgType::OTHER;
+  union
+  {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char *s;
+    const void *p;
+  };
 };
 
 
+/**
+ * @brief Converts a logf() argument into a splhArg. Types not handled by the built-in formatter become
+ *        splhArgType::OTHER, which lets logf() fall back to snprintf().
+ *
+ * @param value     the argument
+ * @return splhArg  the tagged argument
+ */
+template <class T>
+inline splhArg splhMakeArg(T value)
+{
+  splhArg arg;
+  if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+  {
+    arg.type = splhArgType::INT;
+    arg.i = value;
+  }
+  else if constexpr (std::is_integral<T>::value)
+  {
+    arg.type = splhArgType::UINT;
+    arg.u = value;
+  }
+  else if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value)
+  {
+    arg.type = splhArgType::DOUBLE;
+    arg.d = value;
+  }
+  else if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value)
+  {
+    arg.type = splhArgType::STRING;
+    arg.s = value;
+  }
+  else if constexpr (std::is_pointer<T>::value)
+  {
+    arg.type = splhArgType::POINTER;
+    arg.p = (const void*)value;
+  }
+  return arg;
+}
+
+
+int splhFormatMessage(char *buffer, size_t bufferLen, const char *format, const splhArg *args, size_t argCount);
+
+
 /*  typedef for handler callback function
     void myHandlerFunc(const char *message, const splhLevel level, const char *timeString, 
                         const char *fileName, const uint32_t lineNo, const char *funcName);   
 */
 typedef std::function<void(const char*, const splhLevel, const char*, const char*, const uint32_t, const char*)> splhHandlerCallback;
 
+/*  typedef for handler callback function with timestamp (nanoseconds since epoch)
+    void myHandlerFunc(const char *message, const splhLevel level, const char *timeString, const int64_t timestamp,
+                        const char *fileName, const uint32_t lineNo, const char *funcName);   
+*/
+typedef std::function<void(const char*, const splhLevel, const char*, const int64_t, const char*, const uint32_t, const char*)> splhTimestampHandlerCallback;
+
+
+/**
+ * @brief the clock used for the timestamps of log messages. ticks() is cheap enough to be read when the message is
+ *        created and uses the invariant TSC on x86 or the steady clock otherwise. toNanos() converts ticks into
+ *        nanoseconds since epoch with a calibration against the system clock, which is renewed every second. The
+ *        calibration is read without taking a lock, so capturing a timestamp does not serialize logging threads.
+ * 
+ */
+class splhClock {
+
+  private:
+    static bool useTsc();
+
+  public:
+    static uint64_t ticks();
+    static int64_t toNanos(uint64_t ticks);
+    static void calibrate();
+};
+
+
+/**
+ * @brief the context fields (e.g. request id, tenant) of the calling thread, which are added to its log messages by
+ *        splhFormat::CONTEXT. The fields are rendered into a prefix when set, so log messages only copy the prefix.
+ * 
+ */
+class spLogContext {
+
+  public:
+    static void push(const char *key, const char *value);
+    static void pop();
+    static void clear();
+    static const std::vector<std::pair<std::string, std::string>>& fields();
+    static const std::string& prefix();
+    static void setThreadName(const char *name);
+    static const std::string& threadId();
+    static uint32_t threadNo();
+};
+
+
+/**
+ * @brief the spLogContextScope class adding a context field for the lifetime of the object, used via spLOG_CONTEXT().
+ * 
+ */
+class spLogContextScope {
+
+  public:
+    spLogContextScope(const char *key, const char *value)
+    {
+      spLogContext::push(key, value);
+    }
+    ~spLogContextScope()
+    {
+      spLogContext::pop();
+    }
+    spLogContextScope(const spLogContextScope&) = delete;
+    spLogContextScope& operator=(const spLogContextScope&) = delete;
+};
+
 
 /**
  * @brief the spLogHelper class used for preparing the output of log messages.
@@ -149,11 +306,13 @@ class spLogHelper {
     const char* levelText(splhLevel level);
     const char* extractFileName(const char * filePath);
     bool callbacksExist();
-    void handleCallbacks(const splhLevel level, const char *fileName, const uint32_t lineNo, const char *funcName);
+    void handleCallbacks(const splhLevel level, const char *fileName, const uint32_t lineNo, const char *funcName,
+                         const int64_t timestamp);
 
   public:
     ~spLogHelper();
     uint32_t registerHandlerCallback(const splhHandlerCallback callback);
+    uint32_t registerHandlerCallback(const splhTimestampHandlerCallback callback);
     void unregisterHandlerCallback(uint32_t id);
     std::string getTimeFormat();
     void setTimeFormat(std::string formatString);
@@ -161,12 +320,16 @@ class spLogHelper {
     template <class... Vs>
     void logf(splhLevel level, const char *fileName, const uint32_t lineNo, 
                const char *funcName, const char *format, Vs... args);
+    void dispatch(const splhLevel level, const char *fileName, const uint32_t lineNo, const char *funcName,
+                  const int64_t timestamp, const char *message);
 };
 
 
 /**
  * @brief Creates a formatted message and passes it on to each registered callback.
  *        The final variadic arguments can be ommitted and instead a regular string passed to format.
+ *        Formatting is done by the built-in formatter for the common printf() specifiers and by snprintf() for
+ *        anything else.
  * 
  * @param level     a splhLevel value
  * @param fileName  the name of the file (__FILE__)
@@ -181,8 +344,14 @@ void spLogHelper::logf(splhLevel level, const char *fileName, const uint32_t lin
 {
   if (callbacksExist())
   {
-    snprintf(getMsgBufferPointer(), spLOGHELPER_MSGBUFFER_LEN, format, args...);
-    handleCallbacks(level, extractFileName(fileName), lineNo, funcName);
+    uint64_t ticks = splhClock::ticks();
+    char *pBuffer = getMsgBufferPointer();
+    const splhArg argList[] = {splhMakeArg(args)..., splhArg()};
+    if (splhFormatMessage(pBuffer, spLOGHELPER_MSGBUFFER_LEN, format, argList, sizeof...(args)) < 0)
+    {
+      snprintf(pBuffer, spLOGHELPER_MSGBUFFER_LEN, format, args...);
+    }
+    handleCallbacks(level, extractFileName(fileName), lineNo, funcName, splhClock::toNanos(ticks));
   }
 }
 
@@ -0,0 +1,659 @@
+/**
+ * @file spLogShmRing.cpp
+ * @author krokoreit (krokoreit@gmail.com)
+ * @brief a shared memory ring for passing log records from several processes to one collector
+ * @version 1.0.0
+ * @date 2026-10-18
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <spLogShmRing.h>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(SPLH_NO_THREADS)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+
+// shared memory identification
+static const char splhShmMagic[4] = {'S', 'P', 'L', 'R'};
+static const uint32_t splhShmVersion = 1;
+
+
+/**
+ * @brief the start of the shared memory
+ */
+struct splhShmHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t producerCount;
+  uint32_t slotCount;
+  uint32_t slotLen;
+  std::atomic<uint32_t> ready;
+  std::atomic<uint64_t> droppedNoProducer;
+};
+
+/**
+ * @brief a producer entry with the positions of its slots. head is only written by the owning thread, tail only by
+ *        the collector.
+ */
+struct alignas(64) splhShmProducer
+{
+  std::atomic<int32_t> owner;     // pid of the owning process, 0 when free
+  std::atomic<uint64_t> dropped;
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+};
+
+/**
+ * @brief the header of a record in a slot, followed by fileName, funcName and message, each zero terminated
+ */
+struct splhShmRecord
+{
+  int64_t timestamp;
+  uint32_t lineNo;
+  uint8_t level;
+  uint8_t fileLen;
+  uint16_t funcLen;
+  uint16_t msgLen;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "spLogShmRing needs lock free 64 bit atomics");
+
+static const size_t splhShmHeaderLen = (sizeof(splhShmHeader) + 63) & ~(size_t)63;
+
+
+/**
+ * @brief a thread's claim of a producer entry, released when the thread ends
+ */
+struct splhShmClaim
+{
+  uint64_t ringId = 0;
+  std::atomic<int32_t> *pOwner = nullptr;
+  uint32_t generation = 0;
+  int32_t index = -1;
+
+  void release();
+  ~splhShmClaim()
+  {
+    release();
+  }
+};
+
+// process generation, incremented in a forked child, which must not use the parent's claims
+static std::atomic<uint32_t> shmForkGeneration{1};
+
+/**
+ * @brief a ring mapped in this process with the producer entries claimed by its threads
+ */
+struct splhShmMapping
+{
+  uint64_t ringId;
+  std::vector<int32_t> claimed;
+};
+
+// rings mapped in this process
+static std::mutex shmRingsMutex;
+static std::vector<splhShmMapping> shmMappings;
+static uint64_t shmNextRingId = 1;
+
+/**
+ * @brief a thread's claims in the rings it writes to
+ */
+struct splhShmClaims
+{
+  splhShmClaim entries[spLOGSHMRING_THREAD_CLAIMS];
+  uint32_t nextEvict = 0;
+
+  splhShmClaim &find(uint64_t ringId, uint32_t generation);
+};
+
+static thread_local splhShmClaims shmClaims;
+
+
+/**
+ * @brief Releases the claim, if it is still valid in this process and the ring is still mapped.
+ */
+void splhShmClaim::release()
+{
+  if (pOwner != nullptr && generation == shmForkGeneration.load(std::memory_order_relaxed))
+  {
+    std::lock_guard<std::mutex> lock(shmRingsMutex);
+    for (splhShmMapping &mapping : shmMappings)
+    {
+      if (mapping.ringId == ringId)
+      {
+        pOwner->store(0, std::memory_order_release);
+        for (size_t i = 0; i < mapping.claimed.size(); i++)
+        {
+          if (mapping.claimed[i] == index)
+          {
+            mapping.claimed.erase(mapping.claimed.begin() + i);
+            break;
+          }
+        }
+        break;
+      }
+    }
+  }
+  ringId = 0;
+  pOwner = nullptr;
+  index = -1;
+}
+
+/**
+ * @brief Returns the claim for a ring. When the thread has none, an unused or stale entry is released and returned,
+ *        or, with all entries in use, one of them in turn.
+ *
+ * @param ringId      id of the ring
+ * @param generation  current process generation
+ * @return splhShmClaim&  the claim, with a ringId other than the given one when the ring needs to be claimed
+ */
+splhShmClaim &splhShmClaims::find(uint64_t ringId, uint32_t generation)
+{
+  splhShmClaim *pFree = nullptr;
+  for (splhShmClaim &claim : entries)
+  {
+    if (claim.ringId == ringId && claim.generation == generation)
+    {
+      return claim;
+    }
+    if (pFree == nullptr && (claim.ringId == 0 || claim.generation != generation || claim.ringId == ringId))
+    {
+      pFree = &claim;
+    }
+  }
+  if (pFree == nullptr)
+  {
+    pFree = &entries[nextEvict];
+    nextEvict = (nextEvict + 1) % spLOGSHMRING_THREAD_CLAIMS;
+  }
+  pFree->release();
+  return *pFree;
+}
+
+/**
+ * @brief pthread_atfork() child handler.
+ */
+static void shmAfterFork()
+{
+  shmForkGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the steady clock in nanoseconds.
+ */
+static int64_t shmSteadyNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/*    PUBLIC    PUBLIC    PUBLIC    PUBLIC
+
+      xxxxxxx   xx    xx  xxxxxxx   xx           xx      xxxxxx
+      xx    xx  xx    xx  xx    xx  xx           xx     xx    xx
+      xx    xx  xx    xx  xx    xx  xx           xx     xx
+      xxxxxxx   xx    xx  xxxxxxx   xx           xx     xx
+      xx        xx    xx  xx    xx  xx           xx     xx
+      xx        xx    xx  xx    xx  xx           xx     xx    xx
+      xx         xxxxxx   xxxxxxx   xxxxxxxx     xx      xxxxxx
+
+
+      PUBLIC    PUBLIC    PUBLIC    PUBLIC    */
+
+/**
+ * @brief Destroy the spLogShmRing object. Unmaps the shared memory, but leaves it existing for other processes.
+ *
+ */
+spLogShmRing::~spLogShmRing()
+{
+  close();
+}
+
+/**
+ * @brief Creates the shared memory for the ring, replacing any existing one with the same name. To be called by
+ *        the collector, typically before starting the worker processes.
+ *
+ * @param name            name of the shared memory, e.g. "/myapp-log"
+ * @param producerCount   number of producer entries, i.e. threads logging at the same time in all workers
+ * @param slotCount       number of slots per producer
+ * @return true           on success
+ * @return false
+ */
+bool spLogShmRing::create(const char *name, uint32_t producerCount, uint32_t slotCount)
+{
+  close();
+  if (producerCount == 0 || slotCount == 0)
+  {
+    return false;
+  }
+
+  size_t len = splhShmHeaderLen + (size_t)producerCount * sizeof(splhShmProducer)
+               + (size_t)producerCount * slotCount * spLOGSHMRING_SLOT_LEN;
+  shm_unlink(name);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    return false;
+  }
+  if (ftruncate(fd, len) != 0 || !map(fd, len))
+  {
+    ::close(fd);
+    shm_unlink(name);
+    return false;
+  }
+  ::close(fd);
+  _name = name;
+
+  splhShmHeader *pHeader = new (_pHeader) splhShmHeader;
+  memcpy(pHeader->magic, splhShmMagic, 4);
+  pHeader->version = splhShmVersion;
+  pHeader->producerCount = producerCount;
+  pHeader->slotCount = slotCount;
+  pHeader->slotLen = spLOGSHMRING_SLOT_LEN;
+  pHeader->droppedNoProducer.store(0, std::memory_order_relaxed);
+  for (uint32_t i = 0; i < producerCount; i++)
+  {
+    splhShmProducer *pProducer = new (producer(i)) splhShmProducer;
+    pProducer->owner.store(0, std::memory_order_relaxed);
+    pProducer->dropped.store(0, std::memory_order_relaxed);
+    pProducer->head.store(0, std::memory_order_relaxed);
+    pProducer->tail.store(0, std::memory_order_relaxed);
+  }
+  pHeader->ready.store(1, std::memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Opens the shared memory of a ring created by the collector. To be called by the worker processes.
+ *
+ * @param name    name of the shared memory
+ * @return true   on success
+ * @return false
+ */
+bool spLogShmRing::open(const char *name)
+{
+  close();
+
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < splhShmHeaderLen || !map(fd, st.st_size))
+  {
+    ::close(fd);
+    return false;
+  }
+  ::close(fd);
+  _name = name;
+
+  // check that the layout matches this build
+  splhShmHeader *pHeader = _pHeader;
+  if (pHeader->ready.load(std::memory_order_acquire) != 1 || memcmp(pHeader->magic, splhShmMagic, 4) != 0
+      || pHeader->version != splhShmVersion || pHeader->slotLen != spLOGSHMRING_SLOT_LEN
+      || _mapLen < splhShmHeaderLen + (size_t)pHeader->producerCount * sizeof(splhShmProducer)
+                   + (size_t)pHeader->producerCount * pHeader->slotCount * pHeader->slotLen)
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Releases the producer entries claimed by threads of this process and unmaps the shared memory. Threads
+ *        writing into the ring again after another open() claim new entries.
+ *
+ */
+void spLogShmRing::close()
+{
+  if (_pHeader != nullptr)
+  {
+    {
+      int32_t pid = (int32_t)getpid();
+      std::lock_guard<std::mutex> lock(shmRingsMutex);
+      for (size_t i = 0; i < shmMappings.size(); i++)
+      {
+        if (shmMappings[i].ringId == _id)
+        {
+          // only entries still owned by this process, a forked child's copy of the list is stale
+          for (int32_t index : shmMappings[i].claimed)
+          {
+            int32_t owner = pid;
+            producer(index)->owner.compare_exchange_strong(owner, 0, std::memory_order_acq_rel);
+          }
+          shmMappings.erase(shmMappings.begin() + i);
+          break;
+        }
+      }
+    }
+    munmap(_pHeader, _mapLen);
+    _pHeader = nullptr;
+    _mapLen = 0;
+  }
+}
+
+/**
+ * @brief Removes the name of the shared memory, which will be freed when no process has it mapped anymore.
+ *
+ * @return true   on success
+ * @return false
+ */
+bool spLogShmRing::unlink()
+{
+  return !_name.empty() && shm_unlink(_name.c_str()) == 0;
+}
+
+/**
+ * @brief Writes a record into the slots of the calling thread's producer entry. Does not block and does not make
+ *        system calls, except for claiming an entry on the first call in a thread and for yielding while waiting
+ *        for a free slot. A thread keeps its entries in up to spLOGSHMRING_THREAD_CLAIMS rings.
+ *
+ * @param level       a splhLevel value
+ * @param timestamp   nanoseconds since epoch
+ * @param fileName    the name of the file
+ * @param lineNo      the number of the line
+ * @param funcName    the name of the function
+ * @param message     the message text
+ * @param waitMicros  time to wait for the collector to free a slot, when the thread's slots are full
+ * @return true       when written
+ * @return false      when the ring is not open, has no free producer entry or the thread's slots are still full
+ */
+bool spLogShmRing::write(const splhLevel level, const int64_t timestamp, const char *fileName, const uint32_t lineNo,
+                         const char *funcName, const char *message, const uint32_t waitMicros)
+{
+  if (_pHeader == nullptr)
+  {
+    return false;
+  }
+
+  // this thread's producer entry
+  uint32_t generation = shmForkGeneration.load(std::memory_order_relaxed);
+  splhShmClaim &claim = shmClaims.find(_id, generation);
+  if (claim.ringId != _id)
+  {
+    int32_t index = claimProducer();
+    if (index < 0)
+    {
+      _pHeader->droppedNoProducer.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    claim.ringId = _id;
+    claim.pOwner = &producer(index)->owner;
+    claim.generation = generation;
+    claim.index = index;
+    addClaim(index);
+  }
+  splhShmProducer *pProducer = producer(claim.index);
+
+  uint64_t head = pProducer->head.load(std::memory_order_relaxed);
+  if (head - pProducer->tail.load(std::memory_order_acquire) >= _pHeader->slotCount)
+  {
+    // back-pressure, give the collector time to catch up
+    int64_t deadline = shmSteadyNanos() + (int64_t)waitMicros * 1000;
+    while (head - pProducer->tail.load(std::memory_order_acquire) >= _pHeader->slotCount)
+    {
+      if (waitMicros == 0 || shmSteadyNanos() >= deadline)
+      {
+        pProducer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // texts truncated to fit into the slot
+  size_t space = spLOGSHMRING_SLOT_LEN - sizeof(splhShmRecord) - 3;
+  size_t fileLen = strnlen(fileName, 127);
+  size_t funcLen = strnlen(funcName, 127);
+  size_t msgLen = strnlen(message, space - fileLen - funcLen);
+
+  char *pSlot = slot(claim.index, head);
+  splhShmRecord record;
+  record.timestamp = timestamp;
+  record.lineNo = lineNo;
+  record.level = (uint8_t)level;
+  record.fileLen = (uint8_t)fileLen;
+  record.funcLen = (uint16_t)funcLen;
+  record.msgLen = (uint16_t)msgLen;
+  memcpy(pSlot, &record, sizeof(record));
+  char *p = pSlot + sizeof(record);
+  memcpy(p, fileName, fileLen);
+  p[fileLen] = 0;
+  p += fileLen + 1;
+  memcpy(p, funcName, funcLen);
+  p[funcLen] = 0;
+  p += funcLen + 1;
+  memcpy(p, message, msgLen);
+  p[msgLen] = 0;
+
+  pProducer->head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Returns a handler callback, which writes each log message into this ring when registered with a
+ *        spLogHelper object. Use a plain message format for that object, as the collector adds the elements.
+ *
+ * @param waitMicros                       time to wait for a free slot before dropping a record, 0 to never wait
+ * @return splhTimestampHandlerCallback    the callback to register
+ */
+splhTimestampHandlerCallback spLogShmRing::producerCallback(uint32_t waitMicros)
+{
+  return [this, waitMicros](const char *message, const splhLevel level, const char *timeString,
+                            const int64_t timestamp, const char *fileName, const uint32_t lineNo,
+                            const char *funcName)
+  {
+    write(level, timestamp, fileName, lineNo, funcName, message, waitMicros);
+  };
+}
+
+/**
+ * @brief Reads the records from all producer entries and passes them on with logHelper.dispatch() to the callbacks
+ *        registered in this process. Records of each producer are passed in the order written. Only one thread
+ *        in one process may drain a ring. Entries of processes which no longer exist are released once a second.
+ *
+ * @param logHelper     the spLogHelper object to dispatch the records
+ * @param maxRecords    maximum number of records to read
+ * @return size_t       number of records read
+ */
+size_t spLogShmRing::drain(spLogHelper &logHelper, size_t maxRecords)
+{
+  if (_pHeader == nullptr)
+  {
+    return 0;
+  }
+
+  char buffer[spLOGSHMRING_SLOT_LEN];
+  size_t count = 0;
+  uint32_t producerCount = _pHeader->producerCount;
+  for (uint32_t i = 0; i < producerCount && count < maxRecords; i++)
+  {
+    splhShmProducer *pProducer = producer(i);
+    uint64_t tail = pProducer->tail.load(std::memory_order_relaxed);
+    uint64_t head = pProducer->head.load(std::memory_order_acquire);
+    while (tail != head && count < maxRecords)
+    {
+      // copy out and free the slot before dispatching
+      memcpy(buffer, slot(i, tail), spLOGSHMRING_SLOT_LEN);
+      pProducer->tail.store(++tail, std::memory_order_release);
+      count++;
+
+      splhShmRecord record;
+      memcpy(&record, buffer, sizeof(record));
+      if (sizeof(record) + record.fileLen + record.funcLen + record.msgLen + 3 > spLOGSHMRING_SLOT_LEN)
+      {
+        continue;
+      }
+      const char *fileName = buffer + sizeof(record);
+      const char *funcName = fileName + record.fileLen + 1;
+      const char *message = funcName + record.funcLen + 1;
+      logHelper.dispatch((splhLevel)record.level, fileName, record.lineNo, funcName, record.timestamp, message);
+    }
+  }
+
+  int64_t now = shmSteadyNanos();
+  if (now >= _nextLivenessCheck)
+  {
+    _nextLivenessCheck = now + 1000000000;
+    releaseDeadProducers();
+  }
+  return count;
+}
+
+/**
+ * @brief Returns the number of records, which could not be written because the ring was full.
+ *
+ * @return uint64_t   number of dropped records
+ */
+uint64_t spLogShmRing::dropped()
+{
+  if (_pHeader == nullptr)
+  {
+    return 0;
+  }
+  uint64_t count = _pHeader->droppedNoProducer.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < _pHeader->producerCount; i++)
+  {
+    count += producer(i)->dropped.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+
+/*    PRIVATE    PRIVATE    PRIVATE    PRIVATE
+
+      xxxxxxx   xxxxxxx      xx     xx    xx     xx     xxxxxxxx  xxxxxxxx
+      xx    xx  xx    xx     xx     xx    xx    xxxx       xx     xx
+      xx    xx  xx    xx     xx     xx    xx   xx  xx      xx     xx
+      xxxxxxx   xxxxxxx      xx      xx  xx   xx    xx     xx     xxxxxxx
+      xx        xx    xx     xx      xx  xx   xxxxxxxx     xx     xx
+      xx        xx    xx     xx       xxxx    xx    xx     xx     xx
+      xx        xx    xx     xx        xx     xx    xx     xx     xxxxxxxx
+
+
+      PRIVATE    PRIVATE    PRIVATE    PRIVATE    */
+
+/**
+ * @brief Maps the shared memory and registers the mapping for the claims of this process.
+ *
+ * @param fd      file descriptor of the shared memory
+ * @param len     length to map
+ * @return true   on success
+ * @return false
+ */
+bool spLogShmRing::map(int fd, size_t len)
+{
+  void *pMap = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (pMap == MAP_FAILED)
+  {
+    return false;
+  }
+  _pHeader = (splhShmHeader*)pMap;
+  _mapLen = len;
+
+  static std::once_flag atforkOnce;
+  std::call_once(atforkOnce, []() { pthread_atfork(nullptr, nullptr, shmAfterFork); });
+
+  std::lock_guard<std::mutex> lock(shmRingsMutex);
+  _id = shmNextRingId++;
+  shmMappings.push_back({_id, {}});
+  return true;
+}
+
+/**
+ * @brief Returns a producer entry.
+ *
+ * @param index                 index of the entry
+ * @return splhShmProducer*     pointer to the entry
+ */
+splhShmProducer* spLogShmRing::producer(uint32_t index)
+{
+  return (splhShmProducer*)((char*)_pHeader + splhShmHeaderLen) + index;
+}
+
+/**
+ * @brief Returns a slot of a producer entry.
+ *
+ * @param index       index of the producer entry
+ * @param position    head or tail position
+ * @return char*      pointer to the slot
+ */
+char* spLogShmRing::slot(uint32_t index, uint64_t position)
+{
+  char *pSlots = (char*)_pHeader + splhShmHeaderLen + (size_t)_pHeader->producerCount * sizeof(splhShmProducer);
+  return pSlots + ((size_t)index * _pHeader->slotCount + position % _pHeader->slotCount) * spLOGSHMRING_SLOT_LEN;
+}
+
+/**
+ * @brief Claims a free producer entry for the calling thread.
+ *
+ * @return int32_t    index of the entry or -1 if all are in use
+ */
+int32_t spLogShmRing::claimProducer()
+{
+  int32_t pid = (int32_t)getpid();
+  for (uint32_t i = 0; i < _pHeader->producerCount; i++)
+  {
+    int32_t expected = 0;
+    if (producer(i)->owner.compare_exchange_strong(expected, pid, std::memory_order_acq_rel))
+    {
+      return (int32_t)i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief Records a producer entry claimed by a thread of this process, to be released by close().
+ *
+ * @param index   index of the entry
+ */
+void spLogShmRing::addClaim(int32_t index)
+{
+  std::lock_guard<std::mutex> lock(shmRingsMutex);
+  for (splhShmMapping &mapping : shmMappings)
+  {
+    if (mapping.ringId == _id)
+    {
+      mapping.claimed.push_back(index);
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Releases the producer entries of processes, which no longer exist. Records they have written remain in
+ *        their slots and are still drained.
+ *
+ */
+void spLogShmRing::releaseDeadProducers()
+{
+  for (uint32_t i = 0; i < _pHeader->producerCount; i++)
+  {
+    int32_t owner = producer(i)->owner.load(std::memory_order_relaxed);
+    if (owner != 0 && kill(owner, 0) != 0 && errno == ESRCH)
+    {
+      producer(i)->owner.compare_exchange_strong(owner, 0, std::memory_order_acq_rel);
+    }
+  }
+}
+
+
+#endif // (defined(__unix__) || defined(__APPLE__)) && !defined(SPLH_NO_THREADS)
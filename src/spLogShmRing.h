@@ -0,0 +1,98 @@
+/**
+ * @file spLogShmRing.h
+ * @author krokoreit (krokoreit@gmail.com)
+ * @brief a shared memory ring for passing log records from several processes to one collector
+ * @version 1.0.0
+ * @date 2026-10-18
+ * @copyright Copyright (c) 2026
+ *
+ * Notes:
+ *  Available on POSIX systems only and not with SPLH_NO_THREADS.
+ *
+ *  The collector creates the ring with a name, the worker processes open it by that name and register the
+ *  producerCallback() with a spLogHelper object. Each thread logging in a worker claims one of the ring's producer
+ *  entries, keeps it while it writes to up to spLOGSHMRING_THREAD_CLAIMS rings, and is the only writer of its slots, so writing a record needs neither locks nor system calls. Records
+ *  are written into fixed size slots and become visible to the collector, when the producer's head is advanced.
+ *  They remain in shared memory if the worker crashes afterwards. The collector calls drain() to pass the records
+ *  to the callbacks registered in its own process via spLogHelper::dispatch(). A record finding the thread's slots
+ *  full is dropped, unless the producer was given a time to wait for the collector (back-pressure).
+ *
+ *  Note that callbacks are registered for the whole process. Therefore the producer callback must not be registered
+ *  in the process running drain().
+ *
+ */
+
+#ifndef SPLOGSHMRING_H
+#define SPLOGSHMRING_H
+
+#include <spLogHelper.h>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(SPLH_NO_THREADS)
+
+#include <atomic>
+#include <string>
+
+
+// default number of producer entries (logging threads in all workers)
+#ifndef spLOGSHMRING_PRODUCERS
+#define spLOGSHMRING_PRODUCERS  64
+#endif
+
+// default number of slots per producer
+#ifndef spLOGSHMRING_SLOTS
+#define spLOGSHMRING_SLOTS  256
+#endif
+
+// size of a slot including the record header, longer texts get truncated
+#ifndef spLOGSHMRING_SLOT_LEN
+#define spLOGSHMRING_SLOT_LEN  512
+#endif
+
+// number of rings a thread keeps its producer entry claimed in, writing to more rings re-claims entries
+#ifndef spLOGSHMRING_THREAD_CLAIMS
+#define spLOGSHMRING_THREAD_CLAIMS  4
+#endif
+
+
+struct splhShmHeader;
+struct splhShmProducer;
+
+
+/**
+ * @brief the spLogShmRing class used for passing log records via shared memory to a collector process.
+ *
+ */
+class spLogShmRing {
+
+  private:
+    splhShmHeader* _pHeader = nullptr;
+    size_t _mapLen = 0;
+    std::string _name;
+    uint64_t _id = 0;
+    int64_t _nextLivenessCheck = 0;
+
+    bool map(int fd, size_t len);
+    splhShmProducer* producer(uint32_t index);
+    char* slot(uint32_t index, uint64_t position);
+    int32_t claimProducer();
+    void addClaim(int32_t index);
+    void releaseDeadProducers();
+
+  public:
+    ~spLogShmRing();
+    bool create(const char *name, uint32_t producerCount = spLOGSHMRING_PRODUCERS,
+                uint32_t slotCount = spLOGSHMRING_SLOTS);
+    bool open(const char *name);
+    void close();
+    bool unlink();
+    bool write(const splhLevel level, const int64_t timestamp, const char *fileName, const uint32_t lineNo,
+               const char *funcName, const char *message, const uint32_t waitMicros = 0);
+    splhTimestampHandlerCallback producerCallback(uint32_t waitMicros = 0);
+    size_t drain(spLogHelper &logHelper, size_t maxRecords = SIZE_MAX);
+    uint64_t dropped();
+};
+
+
+#endif // (defined(__unix__) || defined(__APPLE__)) && !defined(SPLH_NO_THREADS)
+
+#endif // SPLOGSHMRING_H
@@ -0,0 +1,983 @@
+/**
+ * @file spLogStore.cpp
+ * @author krokoreit (krokoreit@gmail.com)
+ * @brief a log sink writing records into indexed segment files, which can be queried by time, level and call site
+ * @version 1.0.0
+ * @date 2026-10-18
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <spLogStore.h>
+
+#ifndef SPLH_NO_THREADS
+
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+
+
+// index file identification
+static const char splhStoreIndexMagic[4] = {'S', 'P', 'L', 'X'};
+static const uint32_t splhStoreIndexVersion = 3;
+
+// record header after the length field: time, level, lineNo, fileName length, funcName length
+static const uint32_t splhStoreRecordHeaderLen = 8 + 1 + 4 + 2 + 2;
+
+
+/**
+ * @brief Writes a plain value to file.
+ */
+template <class T>
+static bool writeValue(FILE *pFile, const T &value)
+{
+  return fwrite(&value, sizeof(T), 1, pFile) == 1;
+}
+
+/**
+ * @brief Reads a plain value from file.
+ */
+template <class T>
+static bool readValue(FILE *pFile, T &value)
+{
+  return fread(&value, sizeof(T), 1, pFile) == 1;
+}
+
+/**
+ * @brief Writes a string with a 16 bit length prefix to file.
+ */
+static bool writeString(FILE *pFile, const std::string &value)
+{
+  uint16_t len = (uint16_t)value.length();
+  return writeValue(pFile, len) && fwrite(value.data(), 1, len, pFile) == len;
+}
+
+/**
+ * @brief Reads a string with a 16 bit length prefix from file.
+ */
+static bool readString(FILE *pFile, std::string &value)
+{
+  uint16_t len;
+  if (!readValue(pFile, len))
+  {
+    return false;
+  }
+  value.resize(len);
+  return fread(&value[0], 1, len, pFile) == len;
+}
+
+/**
+ * @brief Returns the FNV-1a hash of a site element, with kind telling file name, line number and function name
+ *        apart. Stored in the index files, so it must not depend on the platform's std::hash.
+ */
+static uint64_t siteHash(char kind, const void *pData, size_t len)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  hash = (hash ^ (uint8_t)kind) * 1099511628211ULL;
+  for (size_t i = 0; i < len; i++)
+  {
+    hash = (hash ^ ((const uint8_t*)pData)[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Sets the two bits of hash in a site filter.
+ */
+static void addToSiteFilter(uint64_t *pFilter, uint64_t hash)
+{
+  const uint32_t bits = spLOGSTORE_SITE_FILTER_WORDS * 64;
+  uint32_t bit1 = (uint32_t)(hash % bits);
+  uint32_t bit2 = (uint32_t)((hash >> 32) % bits);
+  pFilter[bit1 / 64] |= (uint64_t)1 << (bit1 % 64);
+  pFilter[bit2 / 64] |= (uint64_t)1 << (bit2 % 64);
+}
+
+/**
+ * @brief Checks whether both bits of hash are set in a site filter.
+ */
+static bool siteFilterContains(const uint64_t *pFilter, uint64_t hash)
+{
+  const uint32_t bits = spLOGSTORE_SITE_FILTER_WORDS * 64;
+  uint32_t bit1 = (uint32_t)(hash % bits);
+  uint32_t bit2 = (uint32_t)((hash >> 32) % bits);
+  return (pFilter[bit1 / 64] & ((uint64_t)1 << (bit1 % 64))) != 0
+         && (pFilter[bit2 / 64] & ((uint64_t)1 << (bit2 % 64))) != 0;
+}
+
+/**
+ * @brief Returns the length of a file or -1, when it cannot be opened.
+ */
+static int64_t fileLength(const std::string &path)
+{
+  FILE *pFile = fopen(path.c_str(), "rb");
+  if (pFile == nullptr)
+  {
+    return -1;
+  }
+  int64_t len = (fseek(pFile, 0, SEEK_END) == 0) ? (int64_t)ftell(pFile) : -1;
+  fclose(pFile);
+  return len;
+}
+
+/**
+ * @brief Reads the next record of a segment file into buffer and points record's members into it.
+ *
+ * @param pFile     segment file positioned at the start of a record
+ * @param buffer    buffer to hold the record
+ * @param record    record to fill
+ * @param skip      true to only move on to the next record
+ * @return uint32_t number of bytes consumed or 0 at the end of file / for a broken record
+ */
+static uint32_t readRecord(FILE *pFile, std::vector<char> &buffer, splhStoreRecord &record, bool skip)
+{
+  uint32_t len;
+  if (!readValue(pFile, len) || len < splhStoreRecordHeaderLen)
+  {
+    return 0;
+  }
+  if (skip)
+  {
+    return fseek(pFile, len, SEEK_CUR) == 0 ? len + sizeof(len) : 0;
+  }
+
+  // raw record followed by room for the zero terminated strings
+  buffer.resize(2 * len + 3);
+  char *p = buffer.data();
+  if (fread(p, 1, len, pFile) != len)
+  {
+    return 0;
+  }
+  uint8_t level;
+  uint16_t fileLen;
+  uint16_t funcLen;
+  memcpy(&record.time, p, 8);
+  memcpy(&level, p + 8, 1);
+  memcpy(&record.lineNo, p + 9, 4);
+  memcpy(&fileLen, p + 13, 2);
+  memcpy(&funcLen, p + 15, 2);
+  if (splhStoreRecordHeaderLen + fileLen + funcLen > len)
+  {
+    return 0;
+  }
+  record.level = (splhLevel)level;
+
+  const char *pSource = p + splhStoreRecordHeaderLen;
+  uint32_t msgLen = len - splhStoreRecordHeaderLen - fileLen - funcLen;
+  char *pTarget = p + len;
+  record.fileName = pTarget;
+  memcpy(pTarget, pSource, fileLen);
+  pTarget[fileLen] = 0;
+  pTarget += fileLen + 1;
+  record.funcName = pTarget;
+  memcpy(pTarget, pSource + fileLen, funcLen);
+  pTarget[funcLen] = 0;
+  pTarget += funcLen + 1;
+  record.message = pTarget;
+  memcpy(pTarget, pSource + fileLen + funcLen, msgLen);
+  pTarget[msgLen] = 0;
+
+  return len + sizeof(len);
+}
+
+
+/*    PUBLIC    PUBLIC    PUBLIC    PUBLIC    
+
+      xxxxxxx   xx    xx  xxxxxxx   xx           xx      xxxxxx 
+      xx    xx  xx    xx  xx    xx  xx           xx     xx    xx
+      xx    xx  xx    xx  xx    xx  xx           xx     xx      
+      xxxxxxx   xx    xx  xxxxxxx   xx           xx     xx      
+      xx        xx    xx  xx    xx  xx           xx     xx      
+      xx        xx    xx  xx    xx  xx           xx     xx    xx
+      xx         xxxxxx   xxxxxxx   xxxxxxxx     xx      xxxxxx 
+     
+
+      PUBLIC    PUBLIC    PUBLIC    PUBLIC    */
+
+/**
+ * @brief Construct a new spLogStore object for segment files in directory. Existing segments will be indexed and
+ *        included in queries, new records are always written to a new segment.
+ *
+ * @param directory       existing directory for the segment and index files
+ * @param segmentRecords  number of records to write into one segment file
+ */
+spLogStore::spLogStore(const char *directory, uint32_t segmentRecords)
+{
+  _directory = directory;
+  if (_directory.length() > 0 && _directory.back() != '/' && _directory.back() != '\\')
+  {
+    _directory.append("/");
+  }
+  _segmentRecords = segmentRecords > 0 ? segmentRecords : 1;
+  openSegments();
+}
+
+/**
+ * @brief Destroy the spLogStore object. Closes the current segment and writes its index.
+ *
+ */
+spLogStore::~spLogStore()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  closeSegment();
+}
+
+/**
+ * @brief Appends a record to the current segment file and adds it to the segment's index.
+ *
+ * @param time      nanoseconds since epoch
+ * @param level     a splhLevel value
+ * @param fileName  the name of the file
+ * @param lineNo    the number of the line
+ * @param funcName  the name of the function
+ * @param message   the message text
+ */
+void spLogStore::write(const int64_t time, const splhLevel level, const char *fileName, const uint32_t lineNo,
+                       const char *funcName, const char *message)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if (_pFile == nullptr)
+  {
+    startSegment();
+    if (_pFile == nullptr)
+    {
+      return;
+    }
+  }
+
+  size_t fileLen = strnlen(fileName, UINT16_MAX);
+  size_t funcLen = strnlen(funcName, UINT16_MAX);
+  size_t msgLen = strlen(message);
+  uint32_t len = splhStoreRecordHeaderLen + fileLen + funcLen + msgLen;
+  uint8_t lvl = (uint8_t)level;
+  uint16_t fLen = (uint16_t)fileLen;
+  uint16_t fnLen = (uint16_t)funcLen;
+
+  _recordBuffer.resize(len + sizeof(len));
+  char *p = _recordBuffer.data();
+  memcpy(p, &len, 4);
+  memcpy(p + 4, &time, 8);
+  memcpy(p + 12, &lvl, 1);
+  memcpy(p + 13, &lineNo, 4);
+  memcpy(p + 17, &fLen, 2);
+  memcpy(p + 19, &fnLen, 2);
+  p += 4 + splhStoreRecordHeaderLen;
+  memcpy(p, fileName, fileLen);
+  memcpy(p + fileLen, funcName, funcLen);
+  memcpy(p + fileLen + funcLen, message, msgLen);
+
+  if (fwrite(_recordBuffer.data(), 1, _recordBuffer.size(), _pFile) != _recordBuffer.size())
+  {
+    abortSegment();
+    return;
+  }
+  addToIndex(_segments.back(), _siteLookup, time, level, fileName, lineNo, funcName, _fileOffset);
+  _fileOffset += _recordBuffer.size();
+
+  if (_segments.back().recordCount >= _segmentRecords)
+  {
+    closeSegment();
+  }
+}
+
+/**
+ * @brief Returns a handler callback, which writes each log message into this store when registered with a
+ *        spLogHelper object. Use a plain message format for that object to avoid storing the formatted elements.
+ *
+ * @return splhTimestampHandlerCallback    the callback to register
+ */
+splhTimestampHandlerCallback spLogStore::handlerCallback()
+{
+  return [this](const char *message, const splhLevel level, const char *timeString, const int64_t timestamp,
+                const char *fileName, const uint32_t lineNo, const char *funcName)
+  {
+    write(timestamp, level, fileName, lineNo, funcName, message);
+  };
+}
+
+/**
+ * @brief Flushes the current segment file.
+ *
+ */
+void spLogStore::flush()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_pFile != nullptr)
+  {
+    fflush(_pFile);
+  }
+}
+
+/**
+ * @brief Finds the records matching query and passes them in order of segments and records to the callback.
+ *        Records written while the query is running are not included.
+ *
+ * @param query       the conditions to match
+ * @param callback    the function to receive the records, which returns false to stop the query
+ * @return size_t     number of records passed to callback
+ */
+size_t spLogStore::query(const splhStoreQuery &query, splhStoreQueryCallback callback)
+{
+  // copy the summaries and the index of the segment being written, the files are read without holding the lock
+  std::vector<splhStoreSegment> segments;
+  splhStoreSegment current;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t closedCount = _segments.size();
+    if (_pFile != nullptr)
+    {
+      fflush(_pFile);
+      current = _segments.back();
+      closedCount--;
+    }
+    segments.assign(_segments.begin(), _segments.begin() + closedCount);
+  }
+
+  size_t count = 0;
+  bool stop = false;
+  for (size_t i = 0; i < segments.size() && !stop; i++)
+  {
+    if (summaryMatches(segments[i], query))
+    {
+      std::shared_ptr<const splhStoreSegment> pIndex = loadIndex(segments[i].number);
+      if (pIndex != nullptr)
+      {
+        count += querySegment(*pIndex, query, callback, stop);
+      }
+    }
+  }
+  if (!stop && summaryMatches(current, query))
+  {
+    count += querySegment(current, query, callback, stop);
+  }
+  return count;
+}
+
+
+/*    PRIVATE    PRIVATE    PRIVATE    PRIVATE
+
+      xxxxxxx   xxxxxxx      xx     xx    xx     xx     xxxxxxxx  xxxxxxxx
+      xx    xx  xx    xx     xx     xx    xx    xxxx       xx     xx      
+      xx    xx  xx    xx     xx     xx    xx   xx  xx      xx     xx      
+      xxxxxxx   xxxxxxx      xx      xx  xx   xx    xx     xx     xxxxxxx    
+      xx        xx    xx     xx      xx  xx   xxxxxxxx     xx     xx    
+      xx        xx    xx     xx       xxxx    xx    xx     xx     xx      
+      xx        xx    xx     xx        xx     xx    xx     xx     xxxxxxxx
+     
+
+      PRIVATE    PRIVATE    PRIVATE    PRIVATE    */
+
+/**
+ * @brief Returns the path of a segment's file.
+ *
+ * @param number          the segment number
+ * @param extension       ".seg" or ".idx"
+ * @return std::string    path of the file
+ */
+std::string spLogStore::segmentPath(uint32_t number, const char *extension)
+{
+  char name[24];
+  snprintf(name, sizeof(name), "splh-%06u%s", number, extension);
+  return _directory + name;
+}
+
+/**
+ * @brief Collects the existing segments, reads the summaries from their index files and rebuilds missing indexes.
+ *
+ */
+void spLogStore::openSegments()
+{
+  // numbers taken from the directory, as older segments may have been removed
+  std::vector<uint32_t> numbers;
+  std::error_code error;
+  for (const std::filesystem::directory_entry &entry :
+       std::filesystem::directory_iterator(_directory.empty() ? "." : _directory, error))
+  {
+    std::string name = entry.path().filename().string();
+    if (name.length() > 9 && name.compare(0, 5, "splh-") == 0 && name.compare(name.length() - 4, 4, ".seg") == 0
+        && name.find_first_not_of("0123456789", 5) == name.length() - 4)
+    {
+      unsigned long number = strtoul(name.c_str() + 5, nullptr, 10);
+      if (number > 0 && number < UINT32_MAX)
+      {
+        numbers.push_back((uint32_t)number);
+      }
+    }
+  }
+  std::sort(numbers.begin(), numbers.end());
+
+  for (uint32_t number : numbers)
+  {
+    splhStoreSegment segment;
+    segment.number = number;
+    if (readIndex(segment, true) || rebuildIndex(segment))
+    {
+      _segments.push_back(summaryOf(segment));
+    }
+    _nextNumber = number + 1;
+  }
+}
+
+/**
+ * @brief Creates a new segment file numbered after all existing segments for writing. An existing segment file is
+ *        never replaced, a stale index file of the new number is removed.
+ *
+ */
+void spLogStore::startSegment()
+{
+  splhStoreSegment segment;
+  for (uint32_t attempt = 0; attempt < 100 && _pFile == nullptr; attempt++)
+  {
+    segment.number = _nextNumber++;
+    _pFile = fopen(segmentPath(segment.number, ".seg").c_str(), "wbx");
+  }
+  if (_pFile != nullptr)
+  {
+    remove(segmentPath(segment.number, ".idx").c_str());
+    _fileOffset = 0;
+    _siteLookup.clear();
+    _segments.push_back(std::move(segment));
+  }
+}
+
+/**
+ * @brief Closes the current segment file and writes its index.
+ *
+ */
+void spLogStore::closeSegment()
+{
+  if (_pFile != nullptr)
+  {
+    fclose(_pFile);
+    _pFile = nullptr;
+    _siteLookup.clear();
+    splhStoreSegment &segment = _segments.back();
+    segment.dataLen = _fileOffset;
+    writeIndex(segment);
+
+    // the full index moves to the cache, the list of segments only needs the summary
+    std::shared_ptr<const splhStoreSegment> pIndex = std::make_shared<const splhStoreSegment>(std::move(segment));
+    segment = summaryOf(*pIndex);
+    cacheIndex(pIndex);
+  }
+}
+
+/**
+ * @brief Closes the current segment after a failed write. Records buffered before may not have been written
+ *        completely either, so the index is rebuilt from the records, which actually are in the file. A segment
+ *        without any complete record is removed.
+ *
+ */
+void spLogStore::abortSegment()
+{
+  fclose(_pFile);
+  _pFile = nullptr;
+  _siteLookup.clear();
+
+  splhStoreSegment &segment = _segments.back();
+  std::shared_ptr<splhStoreSegment> pIndex = std::make_shared<splhStoreSegment>();
+  pIndex->number = segment.number;
+  if (rebuildIndex(*pIndex))
+  {
+    segment = summaryOf(*pIndex);
+    cacheIndex(pIndex);
+  }
+  else
+  {
+    remove(segmentPath(segment.number, ".seg").c_str());
+    remove(segmentPath(segment.number, ".idx").c_str());
+    _segments.pop_back();
+  }
+}
+
+/**
+ * @brief Adds a record to the index of segment.
+ *
+ * @param segment     the segment the record was written to
+ * @param siteLookup  map of site keys to the segment's site entries
+ * @param time        nanoseconds since epoch
+ * @param level       a splhLevel value
+ * @param fileName    the name of the file
+ * @param lineNo      the number of the line
+ * @param funcName    the name of the function
+ * @param offset      the record's position in the segment file
+ */
+void spLogStore::addToIndex(splhStoreSegment &segment, std::unordered_map<std::string, uint32_t> &siteLookup,
+                            const int64_t time, const splhLevel level, const char *fileName, const uint32_t lineNo,
+                            const char *funcName, const uint32_t offset)
+{
+  uint32_t recNo = segment.recordCount++;
+  uint32_t lvl = (uint32_t)level;
+  if (lvl > (uint32_t)splhLevel::NONE)
+  {
+    lvl = (uint32_t)splhLevel::NONE;
+  }
+
+  // block of the sparse time index and bitmap word
+  if (recNo % spLOGSTORE_BLOCK_RECORDS == 0)
+  {
+    segment.blocks.push_back({time, time, offset});
+    for (std::vector<uint64_t> &bitmap : segment.levelBitmaps)
+    {
+      bitmap.push_back(0);
+    }
+  }
+  splhStoreBlock &block = segment.blocks.back();
+  if (time < block.minTime)
+  {
+    block.minTime = time;
+  }
+  if (time > block.maxTime)
+  {
+    block.maxTime = time;
+  }
+  segment.levelBitmaps[lvl].back() |= (uint64_t)1 << (recNo % spLOGSTORE_BLOCK_RECORDS);
+
+  // summary
+  if (time < segment.minTime)
+  {
+    segment.minTime = time;
+  }
+  if (time > segment.maxTime)
+  {
+    segment.maxTime = time;
+  }
+  segment.levelMask |= 1 << lvl;
+
+  // site posting list
+  std::string key(fileName);
+  key.append("\n").append(std::to_string(lineNo)).append("\n").append(funcName);
+  auto found = siteLookup.find(key);
+  if (found == siteLookup.end())
+  {
+    found = siteLookup.emplace(key, (uint32_t)segment.sites.size()).first;
+    segment.sites.push_back({fileName, lineNo, funcName, {}});
+    addToSiteFilter(segment.siteFilter, siteHash('f', fileName, strlen(fileName)));
+    addToSiteFilter(segment.siteFilter, siteHash('l', &lineNo, sizeof(lineNo)));
+    addToSiteFilter(segment.siteFilter, siteHash('u', funcName, strlen(funcName)));
+  }
+  segment.sites[found->second].records.push_back(recNo);
+}
+
+/**
+ * @brief Writes the index file for segment.
+ *
+ * @param segment   the segment with a complete index
+ * @return true     on success
+ * @return false
+ */
+bool spLogStore::writeIndex(splhStoreSegment &segment)
+{
+  FILE *pFile = fopen(segmentPath(segment.number, ".idx").c_str(), "wb");
+  if (pFile == nullptr)
+  {
+    return false;
+  }
+
+  bool ok = fwrite(splhStoreIndexMagic, 1, 4, pFile) == 4
+            && writeValue(pFile, splhStoreIndexVersion)
+            && writeValue(pFile, segment.recordCount)
+            && writeValue(pFile, segment.dataLen)
+            && writeValue(pFile, segment.minTime)
+            && writeValue(pFile, segment.maxTime)
+            && writeValue(pFile, segment.levelMask)
+            && writeValue(pFile, segment.siteFilter);
+
+  uint32_t blockCount = segment.blocks.size();
+  ok = ok && writeValue(pFile, blockCount);
+  for (uint32_t i = 0; ok && i < blockCount; i++)
+  {
+    ok = writeValue(pFile, segment.blocks[i].minTime)
+         && writeValue(pFile, segment.blocks[i].maxTime)
+         && writeValue(pFile, segment.blocks[i].offset);
+  }
+  for (std::vector<uint64_t> &bitmap : segment.levelBitmaps)
+  {
+    ok = ok && fwrite(bitmap.data(), sizeof(uint64_t), blockCount, pFile) == blockCount;
+  }
+
+  uint32_t siteCount = segment.sites.size();
+  ok = ok && writeValue(pFile, siteCount);
+  for (uint32_t i = 0; ok && i < siteCount; i++)
+  {
+    splhStoreSite &site = segment.sites[i];
+    uint32_t recCount = site.records.size();
+    ok = writeString(pFile, site.fileName)
+         && writeValue(pFile, site.lineNo)
+         && writeString(pFile, site.funcName)
+         && writeValue(pFile, recCount)
+         && fwrite(site.records.data(), sizeof(uint32_t), recCount, pFile) == recCount;
+  }
+
+  ok = (fclose(pFile) == 0) && ok;
+  if (!ok)
+  {
+    remove(segmentPath(segment.number, ".idx").c_str());
+  }
+  return ok;
+}
+
+/**
+ * @brief Reads the index file for segment. An index not matching the length of the segment file or with record
+ *        numbers beyond the segment's records is rejected.
+ *
+ * @param segment       the segment to fill
+ * @param summaryOnly   true to only read the summary and load the full index later when needed
+ * @return true         on success
+ * @return false
+ */
+bool spLogStore::readIndex(splhStoreSegment &segment, bool summaryOnly)
+{
+  FILE *pFile = fopen(segmentPath(segment.number, ".idx").c_str(), "rb");
+  if (pFile == nullptr)
+  {
+    return false;
+  }
+
+  char magic[4];
+  uint32_t version;
+  bool ok = fread(magic, 1, 4, pFile) == 4
+            && memcmp(magic, splhStoreIndexMagic, 4) == 0
+            && readValue(pFile, version)
+            && version == splhStoreIndexVersion
+            && readValue(pFile, segment.recordCount)
+            && readValue(pFile, segment.dataLen)
+            && readValue(pFile, segment.minTime)
+            && readValue(pFile, segment.maxTime)
+            && readValue(pFile, segment.levelMask)
+            && readValue(pFile, segment.siteFilter)
+            && (int64_t)segment.dataLen == fileLength(segmentPath(segment.number, ".seg"));
+
+  if (ok && !summaryOnly)
+  {
+    uint32_t blockCount;
+    ok = readValue(pFile, blockCount)
+         && blockCount == (segment.recordCount + spLOGSTORE_BLOCK_RECORDS - 1) / spLOGSTORE_BLOCK_RECORDS;
+    if (ok)
+    {
+      segment.blocks.resize(blockCount);
+    }
+    for (uint32_t i = 0; ok && i < blockCount; i++)
+    {
+      ok = readValue(pFile, segment.blocks[i].minTime)
+           && readValue(pFile, segment.blocks[i].maxTime)
+           && readValue(pFile, segment.blocks[i].offset);
+    }
+    for (std::vector<uint64_t> &bitmap : segment.levelBitmaps)
+    {
+      if (ok)
+      {
+        bitmap.resize(blockCount);
+        ok = fread(bitmap.data(), sizeof(uint64_t), blockCount, pFile) == blockCount;
+      }
+    }
+
+    uint32_t siteCount = 0;
+    ok = ok && readValue(pFile, siteCount);
+    if (ok)
+    {
+      segment.sites.resize(siteCount);
+    }
+    for (uint32_t i = 0; ok && i < siteCount; i++)
+    {
+      splhStoreSite &site = segment.sites[i];
+      uint32_t recCount;
+      ok = readString(pFile, site.fileName)
+           && readValue(pFile, site.lineNo)
+           && readString(pFile, site.funcName)
+           && readValue(pFile, recCount)
+           && recCount <= segment.recordCount;
+      if (ok)
+      {
+        site.records.resize(recCount);
+        ok = fread(site.records.data(), sizeof(uint32_t), recCount, pFile) == recCount;
+      }
+      // record numbers are used as bitmap positions, so a broken index must not point beyond the segment
+      for (uint32_t j = 0; ok && j < recCount; j++)
+      {
+        ok = site.records[j] < segment.recordCount;
+      }
+    }
+  }
+
+  fclose(pFile);
+  return ok;
+}
+
+/**
+ * @brief Creates the index for segment by reading all records of its file. Used for segments without a valid index
+ *        file, e.g. after a crash. A broken record at the end of the file is ignored. No index file is written for
+ *        a segment without records, which is not included in queries.
+ *
+ * @param segment   the segment to index
+ * @return true     on success
+ * @return false
+ */
+bool spLogStore::rebuildIndex(splhStoreSegment &segment)
+{
+  // drop what was read from a rejected index
+  uint32_t number = segment.number;
+  segment = splhStoreSegment();
+  segment.number = number;
+
+  FILE *pFile = fopen(segmentPath(segment.number, ".seg").c_str(), "rb");
+  if (pFile == nullptr)
+  {
+    return false;
+  }
+
+  std::unordered_map<std::string, uint32_t> siteLookup;
+  std::vector<char> buffer;
+  splhStoreRecord record;
+  uint32_t offset = 0;
+  uint32_t len;
+  while ((len = readRecord(pFile, buffer, record, false)) > 0)
+  {
+    addToIndex(segment, siteLookup, record.time, record.level, record.fileName, record.lineNo, record.funcName,
+               offset);
+    offset += len;
+  }
+  segment.dataLen = (fseek(pFile, 0, SEEK_END) == 0) ? (uint32_t)ftell(pFile) : offset;
+  fclose(pFile);
+
+  if (segment.recordCount == 0)
+  {
+    return false;
+  }
+  writeIndex(segment);
+  return true;
+}
+
+/**
+ * @brief Returns a copy of segment without the full index.
+ *
+ * @param segment             the segment
+ * @return splhStoreSegment   the segment's summary
+ */
+spLogStore::splhStoreSegment spLogStore::summaryOf(const splhStoreSegment &segment)
+{
+  splhStoreSegment summary;
+  summary.number = segment.number;
+  summary.recordCount = segment.recordCount;
+  summary.dataLen = segment.dataLen;
+  summary.minTime = segment.minTime;
+  summary.maxTime = segment.maxTime;
+  summary.levelMask = segment.levelMask;
+  memcpy(summary.siteFilter, segment.siteFilter, sizeof(summary.siteFilter));
+  return summary;
+}
+
+/**
+ * @brief Checks whether the summary of segment allows records matching query.
+ *
+ * @param segment   the segment
+ * @param query     the conditions to match
+ * @return true     when the segment may hold matching records
+ * @return false
+ */
+bool spLogStore::summaryMatches(const splhStoreSegment &segment, const splhStoreQuery &query)
+{
+  if (segment.recordCount == 0 || segment.maxTime < query.fromTime || segment.minTime > query.toTime
+      || (segment.levelMask & query.levelMask) == 0)
+  {
+    return false;
+  }
+
+  // sites, a false positive of the filter only costs loading the index
+  return (query.fileName.empty()
+          || siteFilterContains(segment.siteFilter, siteHash('f', query.fileName.data(), query.fileName.length())))
+         && (query.lineNo == 0
+             || siteFilterContains(segment.siteFilter, siteHash('l', &query.lineNo, sizeof(query.lineNo))))
+         && (query.funcName.empty()
+             || siteFilterContains(segment.siteFilter, siteHash('u', query.funcName.data(), query.funcName.length())));
+}
+
+/**
+ * @brief Returns the full index of a segment from the cache and marks it as most recently used.
+ *
+ * @param number    the segment number
+ * @return std::shared_ptr<const splhStoreSegment>    the index or nullptr, when not cached
+ */
+std::shared_ptr<const spLogStore::splhStoreSegment> spLogStore::cachedIndex(uint32_t number)
+{
+  std::lock_guard<std::mutex> lock(_cacheMutex);
+  for (auto it = _cachedIndexes.begin(); it != _cachedIndexes.end(); it++)
+  {
+    if ((*it)->number == number)
+    {
+      _cachedIndexes.splice(_cachedIndexes.begin(), _cachedIndexes, it);
+      return _cachedIndexes.front();
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Adds the full index of a segment to the cache and removes the least recently used indexes beyond
+ *        spLOGSTORE_CACHED_INDEXES. Queries still using a removed index keep it until they are done.
+ *
+ * @param pIndex    the index
+ */
+void spLogStore::cacheIndex(const std::shared_ptr<const splhStoreSegment> &pIndex)
+{
+  std::lock_guard<std::mutex> lock(_cacheMutex);
+  _cachedIndexes.remove_if([&pIndex](const std::shared_ptr<const splhStoreSegment> &pCached)
+  {
+    return pCached->number == pIndex->number;
+  });
+  _cachedIndexes.push_front(pIndex);
+  while (_cachedIndexes.size() > spLOGSTORE_CACHED_INDEXES)
+  {
+    _cachedIndexes.pop_back();
+  }
+}
+
+/**
+ * @brief Returns the full index of a closed segment, from the cache or read from its index file.
+ *
+ * @param number    the segment number
+ * @return std::shared_ptr<const splhStoreSegment>    the index or nullptr, when not available
+ */
+std::shared_ptr<const spLogStore::splhStoreSegment> spLogStore::loadIndex(uint32_t number)
+{
+  std::shared_ptr<const splhStoreSegment> pCached = cachedIndex(number);
+  if (pCached != nullptr)
+  {
+    return pCached;
+  }
+
+  // one load at a time, as a rebuild writes the index file
+  std::lock_guard<std::mutex> lock(_loadMutex);
+  pCached = cachedIndex(number);
+  if (pCached != nullptr)
+  {
+    return pCached;
+  }
+  std::shared_ptr<splhStoreSegment> pIndex = std::make_shared<splhStoreSegment>();
+  pIndex->number = number;
+  if (!readIndex(*pIndex, false) && !rebuildIndex(*pIndex))
+  {
+    return nullptr;
+  }
+  cacheIndex(pIndex);
+  return pIndex;
+}
+
+/**
+ * @brief Passes the records of segment matching query to callback. Blocks without matching records are skipped by
+ *        means of the index.
+ *
+ * @param segment   the segment with its full index
+ * @param query     the conditions to match
+ * @param callback  the function to receive the records
+ * @param stop      set to true, when callback requests to stop
+ * @return size_t   number of records passed to callback
+ */
+size_t spLogStore::querySegment(const splhStoreSegment &segment, const splhStoreQuery &query,
+                                const splhStoreQueryCallback &callback, bool &stop)
+{
+  // records from the matching sites
+  size_t blockCount = segment.blocks.size();
+  bool siteFilter = !query.fileName.empty() || query.lineNo != 0 || !query.funcName.empty();
+  std::vector<uint64_t> siteBitmap;
+  if (siteFilter)
+  {
+    bool found = false;
+    siteBitmap.assign(blockCount, 0);
+    for (const splhStoreSite &site : segment.sites)
+    {
+      if ((query.fileName.empty() || site.fileName == query.fileName)
+          && (query.lineNo == 0 || site.lineNo == query.lineNo)
+          && (query.funcName.empty() || site.funcName == query.funcName))
+      {
+        for (uint32_t recNo : site.records)
+        {
+          siteBitmap[recNo / spLOGSTORE_BLOCK_RECORDS] |= (uint64_t)1 << (recNo % spLOGSTORE_BLOCK_RECORDS);
+        }
+        found = true;
+      }
+    }
+    if (!found)
+    {
+      return 0;
+    }
+  }
+
+  FILE *pFile = nullptr;
+  std::vector<char> buffer;
+  splhStoreRecord record;
+  size_t count = 0;
+  for (size_t b = 0; b < blockCount && !stop; b++)
+  {
+    const splhStoreBlock &block = segment.blocks[b];
+    if (block.maxTime < query.fromTime || block.minTime > query.toTime)
+    {
+      continue;
+    }
+
+    uint64_t candidates = 0;
+    for (uint32_t lvl = 0; lvl < 7; lvl++)
+    {
+      if (query.levelMask & (1 << lvl))
+      {
+        candidates |= segment.levelBitmaps[lvl][b];
+      }
+    }
+    if (siteFilter)
+    {
+      candidates &= siteBitmap[b];
+    }
+    if (candidates == 0)
+    {
+      continue;
+    }
+
+    if (pFile == nullptr)
+    {
+      pFile = fopen(segmentPath(segment.number, ".seg").c_str(), "rb");
+      if (pFile == nullptr)
+      {
+        return count;
+      }
+    }
+    if (fseek(pFile, block.offset, SEEK_SET) != 0)
+    {
+      break;
+    }
+
+    // read the block's records up to the last candidate
+    for (uint32_t i = 0; candidates != 0; i++)
+    {
+      uint64_t bit = (uint64_t)1 << i;
+      bool wanted = (candidates & bit) != 0;
+      if (readRecord(pFile, buffer, record, !wanted) == 0)
+      {
+        candidates = 0;
+        break;
+      }
+      if (wanted)
+      {
+        candidates &= ~bit;
+        if (record.time >= query.fromTime && record.time <= query.toTime)
+        {
+          count++;
+          if (!callback(record))
+          {
+            stop = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  if (pFile != nullptr)
+  {
+    fclose(pFile);
+  }
+  return count;
+}
+
+
+#endif // SPLH_NO_THREADS
@@ -0,0 +1,174 @@
+/**
+ * @file spLogStore.h
+ * @author krokoreit (krokoreit@gmail.com)
+ * @brief a log sink writing records into indexed segment files, which can be queried by time, level and call site
+ * @version 1.0.0
+ * @date 2026-10-18
+ * @copyright Copyright (c) 2026
+ *
+ * Notes:
+ *  Records are appended to segment files (splh-NNNNNN.seg) in the given directory. When a segment is full or the
+ *  store is closed, a sidecar index (splh-NNNNNN.idx) is written with
+ *    - the segment's summary (record count, length of the segment file, time range, levels used and a bloom filter
+ *      of the file names, line numbers and function names of its sites)
+ *    - a sparse time index with time range and file offset for each block of 64 records
+ *    - per-level bitmaps with one bit per record
+ *    - per-site posting lists (file / line / function) with the record numbers logged from each site
+ *  A query uses the summaries to skip whole segments, also when it only asks for a site without a time range,
+ *  and the index to read only blocks holding matching records.
+ *  Only the summaries and the full indexes of the segment being written and of the most recently queried segments
+ *  are kept in memory. Queries read the files without blocking the threads writing into the store.
+ *  Segments may be removed from the directory, e.g. by a retention job, new segments are always numbered after
+ *  the highest existing one. Files are written in the native byte order and are not meant to be exchanged between
+ *  platforms. Not available with SPLH_NO_THREADS.
+ *
+ */
+
+#ifndef SPLOGSTORE_H
+#define SPLOGSTORE_H
+
+#include <spLogHelper.h>
+
+#ifndef SPLH_NO_THREADS
+
+#include <stdio.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// records per block of the sparse time index (one bitmap word)
+#define spLOGSTORE_BLOCK_RECORDS   64
+
+// words of the bloom filter for the sites in a segment's summary
+#define spLOGSTORE_SITE_FILTER_WORDS   32
+
+// default number of records per segment file
+#ifndef spLOGSTORE_SEGMENT_RECORDS
+#define spLOGSTORE_SEGMENT_RECORDS  65536
+#endif
+
+// number of full indexes of closed segments kept in memory for queries
+#ifndef spLOGSTORE_CACHED_INDEXES
+#define spLOGSTORE_CACHED_INDEXES  16
+#endif
+
+
+/**
+ * @brief a log record as delivered by spLogStore::query().
+ *        The char pointers are only valid during the query callback.
+ */
+struct splhStoreRecord
+{
+  int64_t time;           // nanoseconds since epoch
+  splhLevel level;
+  const char *fileName;
+  uint32_t lineNo;
+  const char *funcName;
+  const char *message;
+};
+
+
+/**
+ * @brief the conditions for spLogStore::query(). Empty / zero values match any record.
+ */
+struct splhStoreQuery
+{
+  int64_t fromTime = INT64_MIN;   // nanoseconds since epoch, inclusive
+  int64_t toTime = INT64_MAX;     // nanoseconds since epoch, inclusive
+  uint8_t levelMask = 0xFF;       // bit (1 << level) for each splhLevel to include
+  std::string fileName;
+  uint32_t lineNo = 0;
+  std::string funcName;
+};
+
+
+/*  typedef for query callback function, return false to stop the query
+    bool myQueryFunc(const splhStoreRecord &record);
+*/
+typedef std::function<bool(const splhStoreRecord&)> splhStoreQueryCallback;
+
+
+/**
+ * @brief the spLogStore class used for writing log records into indexed segment files and querying them.
+ *
+ */
+class spLogStore {
+
+  private:
+    struct splhStoreBlock
+    {
+      int64_t minTime;
+      int64_t maxTime;
+      uint32_t offset;
+    };
+    struct splhStoreSite
+    {
+      std::string fileName;
+      uint32_t lineNo;
+      std::string funcName;
+      std::vector<uint32_t> records;
+    };
+    struct splhStoreSegment
+    {
+      uint32_t number = 0;
+      uint32_t recordCount = 0;
+      uint32_t dataLen = 0;
+      int64_t minTime = INT64_MAX;
+      int64_t maxTime = INT64_MIN;
+      uint8_t levelMask = 0;
+      uint64_t siteFilter[spLOGSTORE_SITE_FILTER_WORDS] = {};
+      std::vector<splhStoreBlock> blocks;
+      std::vector<uint64_t> levelBitmaps[7];
+      std::vector<splhStoreSite> sites;
+    };
+
+    std::string _directory;
+    uint32_t _segmentRecords;
+    uint32_t _nextNumber = 1;
+    std::vector<splhStoreSegment> _segments;
+    std::unordered_map<std::string, uint32_t> _siteLookup;
+    FILE* _pFile = nullptr;
+    uint32_t _fileOffset = 0;
+    std::vector<char> _recordBuffer;
+    std::mutex _mutex;
+    std::list<std::shared_ptr<const splhStoreSegment>> _cachedIndexes;
+    std::mutex _cacheMutex;
+    std::mutex _loadMutex;
+
+    std::string segmentPath(uint32_t number, const char *extension);
+    void openSegments();
+    void startSegment();
+    void closeSegment();
+    void abortSegment();
+    void addToIndex(splhStoreSegment &segment, std::unordered_map<std::string, uint32_t> &siteLookup,
+                    const int64_t time, const splhLevel level, const char *fileName, const uint32_t lineNo,
+                    const char *funcName, const uint32_t offset);
+    bool writeIndex(splhStoreSegment &segment);
+    bool readIndex(splhStoreSegment &segment, bool summaryOnly);
+    bool rebuildIndex(splhStoreSegment &segment);
+    static splhStoreSegment summaryOf(const splhStoreSegment &segment);
+    static bool summaryMatches(const splhStoreSegment &segment, const splhStoreQuery &query);
+    std::shared_ptr<const splhStoreSegment> cachedIndex(uint32_t number);
+    void cacheIndex(const std::shared_ptr<const splhStoreSegment> &pIndex);
+    std::shared_ptr<const splhStoreSegment> loadIndex(uint32_t number);
+    size_t querySegment(const splhStoreSegment &segment, const splhStoreQuery &query,
+                        const splhStoreQueryCallback &callback, bool &stop);
+
+  public:
+    spLogStore(const char *directory, uint32_t segmentRecords = spLOGSTORE_SEGMENT_RECORDS);
+    ~spLogStore();
+    void write(const int64_t time, const splhLevel level, const char *fileName, const uint32_t lineNo,
+               const char *funcName, const char *message);
+    splhTimestampHandlerCallback handlerCallback();
+    void flush();
+    size_t query(const splhStoreQuery &query, splhStoreQueryCallback callback);
+};
+
+
+#endif // SPLH_NO_THREADS
+
+#endif // SPLOGSTORE_H
@@ -0,0 +1,345 @@
+/**
+ * @file spLogTrace.cpp
+ * @author krokoreit (krokoreit@gmail.com)
+ * @brief scoped timing spans with export to Chrome trace event JSON
+ * @version 1.0.0
+ * @date 2026-10-18
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <spLogTrace.h>
+
+#ifndef SPLH_NO_THREADS
+
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+
+/**
+ * @brief the buffers of ended threads to be reused, freed at exit
+ */
+struct splhSpanBufferPool
+{
+  std::vector<splhSpanBuffer*> buffers;
+
+  void freeAll()
+  {
+    for (splhSpanBuffer *pBuffer : buffers)
+    {
+      delete pBuffer;
+    }
+    std::vector<splhSpanBuffer*>().swap(buffers);
+  }
+  ~splhSpanBufferPool()
+  {
+    freeAll();
+  }
+};
+
+// buffers of the running threads and of ended threads
+std::mutex traceMutex;
+std::vector<splhSpanBuffer*> traceBuffers;
+splhSpanBufferPool traceFreeBuffers;
+
+/**
+ * @brief the spans of an ended thread, kept for export until clear()
+ */
+struct splhFinishedSpans
+{
+  uint32_t threadNo;
+  std::vector<splhSpan> spans;
+};
+std::vector<splhFinishedSpans> traceFinishedSpans;
+uint64_t traceFinishedDropped = 0;
+
+
+/**
+ * @brief Appends text to json as a quoted and escaped JSON string.
+ */
+static void appendJsonString(std::string &json, const char *text)
+{
+  json.push_back('"');
+  for (const char *p = text; *p; p++)
+  {
+    unsigned char c = (unsigned char)*p;
+    if (c == '"' || c == '\\')
+    {
+      json.push_back('\\');
+      json.push_back(c);
+    }
+    else if (c < 0x20)
+    {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      json.append(escaped);
+    }
+    else
+    {
+      json.push_back(c);
+    }
+  }
+  json.push_back('"');
+}
+
+/**
+ * @brief Appends nanoseconds to json as microseconds with three decimals, as used for Chrome trace events.
+ */
+static void appendMicros(std::string &json, int64_t nanos)
+{
+  char text[32];
+  if (nanos < 0)
+  {
+    json.push_back('-');
+    nanos = -nanos;
+  }
+  snprintf(text, sizeof(text), "%lld.%03d", (long long)(nanos / 1000), (int)(nanos % 1000));
+  json.append(text);
+}
+
+
+/**
+ * @brief Appends a span to json as a complete event ("ph":"X").
+ */
+static void appendSpan(std::string &json, const splhSpan &span, int pid, uint32_t threadNo)
+{
+  int64_t start = splhClock::toNanos(span.startTicks);
+  int64_t end = splhClock::toNanos(span.endTicks);
+
+  // file name without path like in log messages
+  const char *fileName = span.fileName;
+  for (const char *p = span.fileName; *p; p++)
+  {
+    if (*p == '/' || *p == '\\')
+    {
+      fileName = p + 1;
+    }
+  }
+
+  json.append("{\"name\":");
+  appendJsonString(json, span.name);
+  json.append(",\"cat\":\"spLOG\",\"ph\":\"X\",\"ts\":");
+  appendMicros(json, start);
+  json.append(",\"dur\":");
+  appendMicros(json, end - start);
+  json.append(",\"pid\":").append(std::to_string(pid));
+  json.append(",\"tid\":").append(std::to_string(threadNo));
+  json.append(",\"args\":{\"file\":");
+  appendJsonString(json, fileName);
+  json.append(",\"line\":").append(std::to_string(span.lineNo));
+  json.append(",\"func\":");
+  appendJsonString(json, span.funcName);
+  json.append("}}");
+}
+
+
+/*    PUBLIC    PUBLIC    PUBLIC    PUBLIC
+
+      xxxxxxx   xx    xx  xxxxxxx   xx           xx      xxxxxx
+      xx    xx  xx    xx  xx    xx  xx           xx     xx    xx
+      xx    xx  xx    xx  xx    xx  xx           xx     xx
+      xxxxxxx   xx    xx  xxxxxxx   xx           xx     xx
+      xx        xx    xx  xx    xx  xx           xx     xx
+      xx        xx    xx  xx    xx  xx           xx     xx    xx
+      xx         xxxxxx   xxxxxxx   xxxxxxxx     xx      xxxxxx
+
+
+      PUBLIC    PUBLIC    PUBLIC    PUBLIC    */
+
+/**
+ * @brief Writes the spans recorded so far into a Chrome trace event JSON file.
+ *
+ * @param path    path of the file
+ * @return true   on success
+ * @return false
+ */
+bool spLogTrace::writeChromeTrace(const char *path)
+{
+  std::string json = chromeTrace();
+  FILE *pFile = fopen(path, "wb");
+  if (pFile == nullptr)
+  {
+    return false;
+  }
+  bool ok = fwrite(json.data(), 1, json.length(), pFile) == json.length();
+  return (fclose(pFile) == 0) && ok;
+}
+
+/**
+ * @brief Returns the spans recorded so far as Chrome trace event JSON, with one complete event ("ph":"X") per span.
+ *
+ * @return std::string    the JSON text
+ */
+std::string spLogTrace::chromeTrace()
+{
+#if defined(__unix__) || defined(__APPLE__)
+  int pid = (int)getpid();
+#else
+  int pid = 1;
+#endif
+
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(traceMutex);
+  for (splhFinishedSpans &finished : traceFinishedSpans)
+  {
+    for (const splhSpan &span : finished.spans)
+    {
+      json.append(first ? "\n" : ",\n");
+      first = false;
+      appendSpan(json, span, pid, finished.threadNo);
+    }
+  }
+  for (splhSpanBuffer *pBuffer : traceBuffers)
+  {
+    uint32_t count = pBuffer->count.load(std::memory_order_acquire);
+    for (uint32_t i = pBuffer->start; i < count; i++)
+    {
+      json.append(first ? "\n" : ",\n");
+      first = false;
+      appendSpan(json, pBuffer->spans[i], pid, pBuffer->threadNo);
+    }
+  }
+  json.append("\n]}\n");
+  return json;
+}
+
+/**
+ * @brief Removes the spans recorded so far and frees the memory of the spans and buffers of ended threads. A span
+ *        ending in another thread at the same time is either removed or kept as the first one after the clear. The
+ *        space of removed spans is reused by their thread once its buffer is full.
+ *
+ */
+void spLogTrace::clear()
+{
+  std::lock_guard<std::mutex> lock(traceMutex);
+  for (splhSpanBuffer *pBuffer : traceBuffers)
+  {
+    // count is only written by the owning thread
+    pBuffer->start = pBuffer->count.load(std::memory_order_acquire);
+    pBuffer->dropped.store(0, std::memory_order_relaxed);
+  }
+  std::vector<splhFinishedSpans>().swap(traceFinishedSpans);
+  traceFinishedDropped = 0;
+  traceFreeBuffers.freeAll();
+}
+
+/**
+ * @brief Returns the number of spans, which were not recorded because a thread's buffer was full.
+ *
+ * @return uint64_t   number of dropped spans
+ */
+uint64_t spLogTrace::dropped()
+{
+  std::lock_guard<std::mutex> lock(traceMutex);
+  uint64_t count = traceFinishedDropped;
+  for (splhSpanBuffer *pBuffer : traceBuffers)
+  {
+    count += pBuffer->dropped.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+
+/*    PRIVATE    PRIVATE    PRIVATE    PRIVATE
+
+      xxxxxxx   xxxxxxx      xx     xx    xx     xx     xxxxxxxx  xxxxxxxx
+      xx    xx  xx    xx     xx     xx    xx    xxxx       xx     xx
+      xx    xx  xx    xx     xx     xx    xx   xx  xx      xx     xx
+      xxxxxxx   xxxxxxx      xx      xx  xx   xx    xx     xx     xxxxxxx
+      xx        xx    xx     xx      xx  xx   xxxxxxxx     xx     xx
+      xx        xx    xx     xx       xxxx    xx    xx     xx     xx
+      xx        xx    xx     xx        xx     xx    xx     xx     xxxxxxxx
+
+
+      PRIVATE    PRIVATE    PRIVATE    PRIVATE    */
+
+/**
+ * @brief Registers a span buffer for the calling thread, reusing the buffer of an ended thread when available.
+ *
+ * @return splhSpanBuffer*    the buffer
+ */
+splhSpanBuffer* spLogTrace::createThreadBuffer()
+{
+  splhSpanBuffer *pBuffer;
+  std::lock_guard<std::mutex> lock(traceMutex);
+  if (traceFreeBuffers.buffers.empty())
+  {
+    pBuffer = new splhSpanBuffer;
+  }
+  else
+  {
+    pBuffer = traceFreeBuffers.buffers.back();
+    traceFreeBuffers.buffers.pop_back();
+  }
+  // called by the thread itself, the same number as in its log messages
+  pBuffer->threadNo = spLogContext::threadNo();
+  traceBuffers.push_back(pBuffer);
+  return pBuffer;
+}
+
+
+/**
+ * @brief Moves the spans not cleared to the start of the calling thread's full buffer, to make room for new ones.
+ *
+ * @param pBuffer   the thread's buffer
+ * @return true     when there is room now
+ * @return false    when no spans were cleared
+ */
+bool spLogTrace::reclaimCleared(splhSpanBuffer *pBuffer)
+{
+  std::lock_guard<std::mutex> lock(traceMutex);
+  uint32_t start = pBuffer->start;
+  if (start == 0)
+  {
+    return false;
+  }
+  uint32_t count = pBuffer->count.load(std::memory_order_relaxed);
+  memmove(pBuffer->spans, pBuffer->spans + start, (count - start) * sizeof(splhSpan));
+  pBuffer->start = 0;
+  pBuffer->count.store(count - start, std::memory_order_release);
+  return true;
+}
+
+
+/**
+ * @brief Destroy the splhSpanBufferOwner object at the end of its thread. Moves the thread's spans into a list
+ *        sized to their number and hands the buffer over for reuse.
+ *
+ */
+splhSpanBufferOwner::~splhSpanBufferOwner()
+{
+  if (pBuffer == nullptr)
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(traceMutex);
+  uint32_t count = pBuffer->count.load(std::memory_order_acquire);
+  if (count > pBuffer->start)
+  {
+    traceFinishedSpans.push_back({pBuffer->threadNo,
+                                  std::vector<splhSpan>(pBuffer->spans + pBuffer->start, pBuffer->spans + count)});
+  }
+  traceFinishedDropped += pBuffer->dropped.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < traceBuffers.size(); i++)
+  {
+    if (traceBuffers[i] == pBuffer)
+    {
+      traceBuffers.erase(traceBuffers.begin() + i);
+      break;
+    }
+  }
+  pBuffer->count.store(0, std::memory_order_relaxed);
+  pBuffer->start = 0;
+  pBuffer->dropped.store(0, std::memory_order_relaxed);
+  traceFreeBuffers.buffers.push_back(pBuffer);
+  pBuffer = nullptr;
+}
+
+
+#endif // SPLH_NO_THREADS
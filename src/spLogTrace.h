@@ -0,0 +1,165 @@
+/**
+ * @file spLogTrace.h
+ * @author krokoreit (krokoreit@gmail.com)
+ * @brief scoped timing spans with export to Chrome trace event JSON
+ * @version 1.0.0
+ * @date 2026-10-18
+ * @copyright Copyright (c) 2026
+ *
+ * Notes:
+ *  A span records only the start and end ticks and the call site into a buffer of the calling thread. Nothing is
+ *  formatted until the spans are exported with spLogTrace::writeChromeTrace(), which creates a file to be opened
+ *  with chrome://tracing or https://ui.perfetto.dev. When a thread ends, its spans are moved into a list sized to
+ *  their number and its buffer is reused by the next thread starting to record spans.
+ *  Not available with SPLH_NO_THREADS, where spLOG_SCOPE() compiles to nothing.
+ *
+ */
+
+#ifndef SPLOGTRACE_H
+#define SPLOGTRACE_H
+
+#include <spLogHelper.h>
+#include <atomic>
+#include <string>
+
+
+// scope macro, active with DEBUG messages
+#if SPLH_LOG_LEVEL_LIMIT <= SPLH_LOG_LEVEL_DEBUG && !defined(SPLH_NO_THREADS)
+#define spLOG_SCOPE(name)   spLogScope SPLH_CONCAT(splhScope, __LINE__)(name, __FILE__, __LINE__, __func__)
+#else
+#define spLOG_SCOPE(name)   spLOG_SUPPRESSED
+#endif
+
+
+#ifndef SPLH_NO_THREADS
+
+// number of spans buffered per thread, further spans are dropped
+#ifndef spLOGTRACE_THREAD_SPANS
+#define spLOGTRACE_THREAD_SPANS  4096
+#endif
+
+
+/**
+ * @brief a recorded span
+ */
+struct splhSpan
+{
+  const char *name;
+  const char *fileName;
+  uint32_t lineNo;
+  const char *funcName;
+  uint64_t startTicks;
+  uint64_t endTicks;
+};
+
+
+/**
+ * @brief the spans recorded by one thread. Only the owning thread writes the spans and count, which is published
+ *        after each span. clear() only moves start behind the spans published so far, so a span being written at the
+ *        same time is not lost and the cleared ones do not reappear.
+ */
+struct splhSpanBuffer
+{
+  splhSpan spans[spLOGTRACE_THREAD_SPANS];
+  std::atomic<uint32_t> count{0};
+  uint32_t start = 0;     // first span not cleared, guarded by traceMutex
+  std::atomic<uint64_t> dropped{0};
+  uint32_t threadNo = 0;
+};
+
+
+/**
+ * @brief the owner of a thread's span buffer, which hands the buffer back when the thread ends
+ */
+struct splhSpanBufferOwner
+{
+  splhSpanBuffer *pBuffer = nullptr;
+  ~splhSpanBufferOwner();
+};
+
+
+/**
+ * @brief the spLogTrace class used for collecting and exporting the spans of all threads.
+ *
+ */
+class spLogTrace {
+
+  private:
+    static splhSpanBuffer* createThreadBuffer();
+    static bool reclaimCleared(splhSpanBuffer *pBuffer);
+    friend class spLogScope;
+
+  public:
+    static splhSpanBuffer* threadBuffer();
+    static bool writeChromeTrace(const char *path);
+    static std::string chromeTrace();
+    static void clear();
+    static uint64_t dropped();
+};
+
+
+/**
+ * @brief the spLogScope class recording a span from its creation to its destruction, used via spLOG_SCOPE().
+ *
+ */
+class spLogScope {
+
+  private:
+    const char *_name;
+    const char *_fileName;
+    uint32_t _lineNo;
+    const char *_funcName;
+    uint64_t _startTicks;
+
+  public:
+    spLogScope(const char *name, const char *fileName, const uint32_t lineNo, const char *funcName)
+      : _name(name), _fileName(fileName), _lineNo(lineNo), _funcName(funcName), _startTicks(splhClock::ticks())
+    {
+    }
+    ~spLogScope();
+    spLogScope(const spLogScope&) = delete;
+    spLogScope& operator=(const spLogScope&) = delete;
+};
+
+
+/**
+ * @brief Returns the span buffer of the calling thread, which is created on first use.
+ *
+ * @return splhSpanBuffer*    the thread's buffer
+ */
+inline splhSpanBuffer* spLogTrace::threadBuffer()
+{
+  static thread_local splhSpanBufferOwner owner;
+  if (owner.pBuffer == nullptr)
+  {
+    owner.pBuffer = createThreadBuffer();
+  }
+  return owner.pBuffer;
+}
+
+/**
+ * @brief Destroy the spLogScope object and record the span into the thread's buffer.
+ *
+ */
+inline spLogScope::~spLogScope()
+{
+  uint64_t endTicks = splhClock::ticks();
+  splhSpanBuffer *pBuffer = spLogTrace::threadBuffer();
+  uint32_t count = pBuffer->count.load(std::memory_order_relaxed);
+  if (count >= spLOGTRACE_THREAD_SPANS)
+  {
+    if (!spLogTrace::reclaimCleared(pBuffer))
+    {
+      pBuffer->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    count = pBuffer->count.load(std::memory_order_relaxed);
+  }
+  pBuffer->spans[count] = {_name, _fileName, _lineNo, _funcName, _startTicks, endTicks};
+  pBuffer->count.store(count + 1, std::memory_order_release);
+}
+
+
+#endif // SPLH_NO_THREADS
+
+#endif // SPLOGTRACE_H